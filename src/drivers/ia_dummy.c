@@ -106,6 +106,12 @@ static int ia_dummy_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   return rc;
 }
 
+static int ia_dummy_seek(iacontext *ctx, iakv *kv) {
+  (void)ctx;
+  (void)kv;
+  return 0;
+}
+
 static int ia_dummy_option(iacontext *ctx, const char *arg) {
   iadriver *drv = ioarena.driver;
   printf("%s.option(%s %p, %s)\n", drv->name, ctx ? "doer" : "global", ctx,
@@ -120,9 +126,11 @@ iadriver ia_dummy = {.name = "dummy",
                      .open = ia_dummy_open,
                      .close = ia_dummy_close,
                      .option = ia_dummy_option,
+                     .reserve = 1,
 
                      .thread_new = ia_dummy_thread_new,
                      .thread_dispose = ia_dummy_thread_dispose,
                      .begin = ia_dummy_begin,
                      .next = ia_dummy_next,
+                     .seek = ia_dummy_seek,
                      .done = ia_dummy_done};
@@ -313,10 +313,15 @@ bailout:
   return -1;
 }
 
+static const char *ia_forestdb_version(void) {
+  return fdb_get_lib_version();
+}
+
 iadriver ia_forestdb = {.name = "forestdb",
                         .priv = NULL,
                         .open = ia_forestdb_open,
                         .close = ia_forestdb_close,
+                        .version = ia_forestdb_version,
 
                         .thread_new = ia_forestdb_thread_new,
                         .thread_dispose = ia_forestdb_thread_dispose,
@@ -206,10 +206,13 @@ finish:
   return rci;
 }
 
+static const char *ia_iowow_version(void) { return iowow_version_full(); }
+
 iadriver ia_iowow = {.name = "iowow",
                      .priv = NULL,
                      .open = ia_iowow_open,
                      .close = ia_iowow_close,
+                     .version = ia_iowow_version,
                      .thread_new = ia_iowow_thread_new,
                      .thread_dispose = ia_iowow_thread_dispose,
                      .begin = ia_iowow_begin,
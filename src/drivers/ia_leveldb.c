@@ -115,8 +115,6 @@ static int ia_leveldb_begin(iacontext *ctx, iabenchmark step) {
 
   switch (step) {
   case IA_GET:
-  case IA_SET:
-  case IA_DELETE:
     break;
 
   case IA_ITERATE:
@@ -128,6 +126,11 @@ static int ia_leveldb_begin(iacontext *ctx, iabenchmark step) {
     leveldb_iter_seek_to_first(ctx->it);
     break;
 
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_CRUD:
   case IA_BATCH:
     ctx->batch = leveldb_writebatch_create();
@@ -160,8 +163,6 @@ static int ia_leveldb_done(iacontext *ctx, iabenchmark step) {
       free(ctx->result);
       ctx->result = NULL;
     }
-  case IA_SET:
-  case IA_DELETE:
     break;
 
   case IA_ITERATE:
@@ -171,6 +172,8 @@ static int ia_leveldb_done(iacontext *ctx, iabenchmark step) {
     }
     break;
 
+  case IA_SET:
+  case IA_DELETE:
   case IA_CRUD:
   case IA_BATCH:
     if (ctx->batch) {
@@ -195,6 +198,11 @@ bailout:
   return -1;
 }
 
+static int ia_leveldb_seek(iacontext *ctx, iakv *kv) {
+  leveldb_iter_seek(ctx->it, kv->k, kv->ksize);
+  return leveldb_iter_valid(ctx->it) ? 0 : ENOENT;
+}
+
 static int ia_leveldb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   iaprivate *self = ioarena.driver->priv;
   int rc = 0;
@@ -257,13 +265,71 @@ bailout:
   return -1;
 }
 
+static const char *ia_leveldb_version(void) {
+  static char version[32];
+  snprintf(version, sizeof(version), "%d.%d", leveldb_major_version(),
+           leveldb_minor_version());
+  return version;
+}
+
+static int ia_leveldb_counters(iacounter *counters, int limit) {
+  iaprivate *self = ioarena.driver->priv;
+  if (!self || !self->db || limit < 4)
+    return 0;
+
+  char *l0 = leveldb_property_value(self->db, "leveldb.num-files-at-level0");
+  char *stats = leveldb_property_value(self->db, "leveldb.stats");
+  char *memory =
+      leveldb_property_value(self->db, "leveldb.approximate-memory-usage");
+
+  /* sum up the per-level table of "leveldb.stats", i.e. the lines
+   * "Level Files Size(MB) Time(sec) Read(MB) Write(MB)" after the dashes */
+  double read_mb = NAN, write_mb = NAN;
+  const char *line = stats ? strstr(stats, "---\n") : NULL;
+  if (line) {
+    read_mb = write_mb = 0;
+    while ((line = strchr(line, '\n')) != NULL) {
+      int level, files;
+      double size, time, read, write;
+      line += 1;
+      if (sscanf(line, "%d %d %lf %lf %lf %lf", &level, &files, &size, &time,
+                 &read, &write) == 6) {
+        read_mb += read;
+        write_mb += write;
+      }
+    }
+  }
+
+  const double mega = 1 << 20;
+  counters[0].name = "l0";
+  counters[0].value = l0 ? strtod(l0, NULL) : NAN;
+  counters[0].cumulative = 0;
+  counters[1].name = "compact_read";
+  counters[1].value = read_mb * mega;
+  counters[1].cumulative = 1;
+  counters[2].name = "compact_write";
+  counters[2].value = write_mb * mega;
+  counters[2].cumulative = 1;
+  counters[3].name = "memory";
+  counters[3].value = memory ? strtod(memory, NULL) : NAN;
+  counters[3].cumulative = 0;
+
+  free(l0);
+  free(stats);
+  free(memory);
+  return 4;
+}
+
 iadriver ia_leveldb = {.name = "leveldb",
                        .priv = NULL,
                        .open = ia_leveldb_open,
                        .close = ia_leveldb_close,
+                       .version = ia_leveldb_version,
+                       .counters = ia_leveldb_counters,
 
                        .thread_new = ia_leveldb_thread_new,
                        .thread_dispose = ia_leveldb_thread_dispose,
                        .begin = ia_leveldb_begin,
                        .next = ia_leveldb_next,
+                       .seek = ia_leveldb_seek,
                        .done = ia_leveldb_done};
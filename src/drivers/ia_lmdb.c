@@ -19,6 +19,7 @@ struct iaprivate {
 struct iacontext {
   MDB_txn *txn;
   MDB_cursor *cursor;
+  int seeked /* the cursor is at the record for the next */;
 };
 
 static int ia_lmdb_open(const char *datadir) {
@@ -166,6 +167,7 @@ static int ia_lmdb_begin(iacontext *ctx, iabenchmark step) {
     }
 
     if (step == IA_ITERATE) {
+      ctx->seeked = 0;
       if (ctx->cursor) {
         rc = mdb_cursor_renew(ctx->txn, ctx->cursor);
         if (rc != MDB_SUCCESS) {
@@ -230,10 +232,25 @@ bailout:
   return -1;
 }
 
+static int ia_lmdb_seek(iacontext *ctx, iakv *kv) {
+  MDB_val k, v;
+  k.mv_data = kv->k;
+  k.mv_size = kv->ksize;
+  int rc = mdb_cursor_get(ctx->cursor, &k, &v, MDB_SET_RANGE);
+  if (rc == MDB_NOTFOUND)
+    return ENOENT;
+  if (rc != MDB_SUCCESS) {
+    ia_log("error: %s, %s (%d)", "mdb_cursor_get", mdb_strerror(rc), rc);
+    return -1;
+  }
+  ctx->seeked = 1;
+  return 0;
+}
+
 static int ia_lmdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   iaprivate *self = ioarena.driver->priv;
   MDB_val k, v;
-  int rc;
+  int rc, reserve;
 
   switch (step) {
   case IA_SET:
@@ -241,9 +258,12 @@ static int ia_lmdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     k.mv_size = kv->ksize;
     v.mv_data = kv->v;
     v.mv_size = kv->vsize;
-    rc = mdb_put(ctx->txn, self->dbi, &k, &v, 0);
+    reserve = !kv->v && kv->vsize;
+    rc = mdb_put(ctx->txn, self->dbi, &k, &v, reserve ? MDB_RESERVE : 0);
     if (rc != MDB_SUCCESS)
       goto bailout;
+    if (reserve)
+      ia_kv_value(kv, v.mv_data);
     break;
 
   case IA_DELETE:
@@ -257,7 +277,9 @@ static int ia_lmdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     break;
 
   case IA_ITERATE:
-    rc = mdb_cursor_get(ctx->cursor, &k, &v, MDB_NEXT);
+    rc = mdb_cursor_get(ctx->cursor, &k, &v,
+                        ctx->seeked ? MDB_GET_CURRENT : MDB_NEXT);
+    ctx->seeked = 0;
     if (rc == MDB_SUCCESS) {
       kv->k = k.mv_data;
       kv->ksize = k.mv_size;
@@ -282,7 +304,10 @@ static int ia_lmdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
       if (rc != MDB_NOTFOUND)
         goto bailout;
       rc = ENOENT;
+      break;
     }
+    kv->v = v.mv_data;
+    kv->vsize = v.mv_size;
     break;
 
   default:
@@ -298,13 +323,20 @@ bailout:
   return -1;
 }
 
+static const char *ia_lmdb_version(void) {
+  return mdb_version(NULL, NULL, NULL);
+}
+
 iadriver ia_lmdb = {.name = "lmdb",
                     .priv = NULL,
                     .open = ia_lmdb_open,
                     .close = ia_lmdb_close,
+                    .version = ia_lmdb_version,
+                    .reserve = 1,
 
                     .thread_new = ia_lmdb_thread_new,
                     .thread_dispose = ia_lmdb_thread_dispose,
                     .begin = ia_lmdb_begin,
                     .next = ia_lmdb_next,
+                    .seek = ia_lmdb_seek,
                     .done = ia_lmdb_done};
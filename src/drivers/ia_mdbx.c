@@ -16,6 +16,7 @@ struct iaprivate {
 };
 
 #define INVALID_DBI ((MDBX_dbi)-1)
+#define UNSET -1
 
 struct mdbx_opts {
   int8_t liforeclaim;
@@ -25,9 +26,37 @@ struct mdbx_opts {
   int8_t nomeminit;
   int8_t nordahead;
   int8_t nometasync;
+  intmax_t size_lower, size_now, size_upper;
+  intmax_t growth, shrink, pagesize;
 };
 
-static struct mdbx_opts globals;
+static struct mdbx_opts globals = {.size_lower = UNSET,
+                                   .size_now = UNSET,
+                                   .size_upper = UNSET,
+                                   .growth = UNSET,
+                                   .shrink = UNSET,
+                                   .pagesize = UNSET};
+
+/* the runtime options, see mdbx_env_set_option() */
+static struct {
+  const char *name;
+  MDBX_option_t id;
+  intmax_t value;
+} tunables[] = {
+    {"RP_AUGMENT_LIMIT", MDBX_opt_rp_augment_limit, UNSET},
+    {"TXN_DP_LIMIT", MDBX_opt_txn_dp_limit, UNSET},
+    {"TXN_DP_INITIAL", MDBX_opt_txn_dp_initial, UNSET},
+    {"DP_RESERVE_LIMIT", MDBX_opt_dp_reserve_limit, UNSET},
+    {"LOOSE_LIMIT", MDBX_opt_loose_limit, UNSET},
+    {"SPILL_MAX_DENOMINATOR", MDBX_opt_spill_max_denominator, UNSET},
+    {"SPILL_MIN_DENOMINATOR", MDBX_opt_spill_min_denominator, UNSET},
+    {"SPILL_PARENT4CHILD_DENOMINATOR",
+     MDBX_opt_spill_parent4child_denominator, UNSET},
+    {"SYNC_BYTES", MDBX_opt_sync_bytes, UNSET},
+    {"SYNC_PERIOD", MDBX_opt_sync_period, UNSET},
+};
+
+#define TUNABLES_COUNT ((int)(sizeof(tunables) / sizeof(tunables[0])))
 
 static int ia_mdbx_option(iacontext *ctx, const char *arg) {
   if (ctx)
@@ -41,11 +70,22 @@ static int ia_mdbx_option(iacontext *ctx, const char *arg) {
     ia_log("  -o %s=<ON|OFF>", "NOMEMINIT");
     ia_log("  -o %s=<ON|OFF>", "NORDAHEAD");
     ia_log("  -o %s=<ON|OFF>", "NOMETASYNC");
+    ia_log("  -o %s=<bytes> (default: 4G)", "SIZE_LOWER");
+    ia_log("  -o %s=<bytes> (default: 4G)", "SIZE_NOW");
+    ia_log("  -o %s=<bytes> (default: 128G)", "SIZE_UPPER");
+    ia_log("  -o %s=<bytes> (default: 64M)", "GROWTH");
+    ia_log("  -o %s=<bytes> (default: 128M)", "SHRINK");
+    ia_log("  -o %s=<bytes> (default: system page)", "PAGESIZE");
+    for (int i = 0; i < TUNABLES_COUNT; ++i)
+      ia_log("  -o %s=<number>", tunables[i].name);
+    ia_log("     SYNC_PERIOD is in milliseconds, sizes could be given with "
+           "K, M, G or T suffix");
     return 0;
   }
 
   int done = 0;
   while (*arg && !done) {
+    const char *const prev = arg;
     done = ia_parse_option_bool(&arg, "LIFORECLAIM", &globals.liforeclaim);
     if (!done)
       done = ia_parse_option_bool(&arg, "COALESCE", &globals.coalesce);
@@ -59,6 +99,22 @@ static int ia_mdbx_option(iacontext *ctx, const char *arg) {
       done = ia_parse_option_bool(&arg, "NORDAHEAD", &globals.nordahead);
     if (!done)
       done = ia_parse_option_bool(&arg, "NOMETASYNC", &globals.nometasync);
+    if (!done)
+      done = ia_parse_option_size(&arg, "SIZE_LOWER", &globals.size_lower);
+    if (!done)
+      done = ia_parse_option_size(&arg, "SIZE_NOW", &globals.size_now);
+    if (!done)
+      done = ia_parse_option_size(&arg, "SIZE_UPPER", &globals.size_upper);
+    if (!done)
+      done = ia_parse_option_size(&arg, "GROWTH", &globals.growth);
+    if (!done)
+      done = ia_parse_option_size(&arg, "SHRINK", &globals.shrink);
+    if (!done)
+      done = ia_parse_option_size(&arg, "PAGESIZE", &globals.pagesize);
+    for (int i = 0; !done && i < TUNABLES_COUNT; ++i)
+      done = ia_parse_option_size(&arg, tunables[i].name, &tunables[i].value);
+    if (!done && arg == prev)
+      break /* unknown option */;
   }
 
   if (done == 1)
@@ -67,6 +123,10 @@ static int ia_mdbx_option(iacontext *ctx, const char *arg) {
   return done ? done : -1;
 }
 
+static intmax_t peek_option(intmax_t value, intmax_t dflt) {
+  return (value != UNSET) ? value : dflt;
+}
+
 static int peek_option_bool(int dflt, int opt, int8_t from) {
   switch (from) {
   default:
@@ -85,6 +145,7 @@ static int peek_option_bool(int dflt, int opt, int8_t from) {
 struct iacontext {
   MDBX_txn *txn;
   MDBX_cursor *cursor;
+  int seeked /* the cursor is at the record for the next */;
 };
 
 static int ia_mdbx_open(const char *datadir) {
@@ -101,22 +162,18 @@ static int ia_mdbx_open(const char *datadir) {
   if (rc != MDBX_SUCCESS)
     goto bailout;
 
-  const size_t kilo = 1024;
-  const size_t mega = kilo << 10;
-  const size_t giga = mega << 10;
-  /* FIXME: define values via command-line args */
+  const intmax_t kilo = 1024;
+  const intmax_t mega = kilo << 10;
+  const intmax_t giga = mega << 10;
+  /* by default 4Gb initial DB size,
+   * to make the benchmark conditions the same as for LMDB */
   rc = mdbx_env_set_geometry(
-      self->env,
-#if 1
-      /* 4Gb initial DB size,
-       * to make the benchmark conditions the same as for LMDB */
-      4 * giga /* size_lower */, 4 * giga /* size_now */,
-#else
-      /* dynamic DB size 1Mb..128Gb */
-      1 * mega /* size_lower */, 64 * mega /* size_now */,
-#endif
-      128 * giga /* size_upper */, 64 * mega /* growth_step */,
-      128 * mega /* shrink_threshold */, -1 /* default pagesize */);
+      self->env, peek_option(globals.size_lower, 4 * giga),
+      peek_option(globals.size_now, 4 * giga),
+      peek_option(globals.size_upper, 128 * giga),
+      peek_option(globals.growth, 64 * mega),
+      peek_option(globals.shrink, 128 * mega),
+      peek_option(globals.pagesize, -1 /* default pagesize */));
   if (rc != MDBX_SUCCESS)
     goto bailout;
 
@@ -164,6 +221,29 @@ static int ia_mdbx_open(const char *datadir) {
   rc = mdbx_env_open(self->env, datadir, modeflags, 0644);
   if (rc != MDBX_SUCCESS)
     goto bailout;
+
+  for (int i = 0; i < TUNABLES_COUNT; ++i) {
+    if (tunables[i].value == UNSET)
+      continue;
+    uint64_t value = tunables[i].value;
+    if (tunables[i].id == MDBX_opt_sync_period)
+      value = value * 65536 / 1000 /* ms to 16.16 seconds */;
+    rc = mdbx_env_set_option(self->env, tunables[i].id, value);
+    if (rc != MDBX_SUCCESS) {
+      ia_log("error: %s, %s=%jd", __func__, tunables[i].name,
+             tunables[i].value);
+      goto bailout;
+    }
+  }
+
+  MDBX_envinfo info;
+  rc = mdbx_env_info_ex(self->env, NULL, &info, sizeof(info));
+  if (rc != MDBX_SUCCESS)
+    goto bailout;
+  ia_log("mdbx: geometry %ju..%ju..%ju, growth %ju, shrink %ju, pagesize %u",
+         (uintmax_t)info.mi_geo.lower, (uintmax_t)info.mi_geo.current,
+         (uintmax_t)info.mi_geo.upper, (uintmax_t)info.mi_geo.grow,
+         (uintmax_t)info.mi_geo.shrink, info.mi_dxb_pagesize);
   return 0;
 
 bailout:
@@ -276,6 +356,7 @@ static int ia_mdbx_begin(iacontext *ctx, iabenchmark step) {
     }
 
     if (step == IA_ITERATE) {
+      ctx->seeked = 0;
       if (ctx->cursor) {
         rc = mdbx_cursor_renew(ctx->txn, ctx->cursor);
         if (rc != MDBX_SUCCESS) {
@@ -347,10 +428,25 @@ bailout:
   return -1;
 }
 
+static int ia_mdbx_seek(iacontext *ctx, iakv *kv) {
+  MDBX_val k, v;
+  k.iov_base = kv->k;
+  k.iov_len = kv->ksize;
+  int rc = mdbx_cursor_get(ctx->cursor, &k, &v, MDBX_SET_RANGE);
+  if (rc == MDBX_NOTFOUND)
+    return ENOENT;
+  if (rc != MDBX_SUCCESS) {
+    ia_log("error: %s, %s (%d)", "mdbx_cursor_get", mdbx_strerror(rc), rc);
+    return -1;
+  }
+  ctx->seeked = 1;
+  return 0;
+}
+
 static int ia_mdbx_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   iaprivate *self = ioarena.driver->priv;
   MDBX_val k, v;
-  int rc;
+  int rc, reserve;
 
   switch (step) {
   case IA_SET:
@@ -358,9 +454,12 @@ static int ia_mdbx_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     k.iov_len = kv->ksize;
     v.iov_base = kv->v;
     v.iov_len = kv->vsize;
-    rc = mdbx_put(ctx->txn, self->dbi, &k, &v, 0);
+    reserve = !kv->v && kv->vsize;
+    rc = mdbx_put(ctx->txn, self->dbi, &k, &v, reserve ? MDBX_RESERVE : 0);
     if (rc != MDBX_SUCCESS)
       goto bailout;
+    if (reserve)
+      ia_kv_value(kv, v.iov_base);
     break;
 
   case IA_DELETE:
@@ -374,7 +473,9 @@ static int ia_mdbx_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     break;
 
   case IA_ITERATE:
-    rc = mdbx_cursor_get(ctx->cursor, &k, &v, MDBX_NEXT);
+    rc = mdbx_cursor_get(ctx->cursor, &k, &v,
+                         ctx->seeked ? MDBX_GET_CURRENT : MDBX_NEXT);
+    ctx->seeked = 0;
     if (rc == MDBX_SUCCESS) {
       kv->k = k.iov_base;
       kv->ksize = k.iov_len;
@@ -399,7 +500,10 @@ static int ia_mdbx_next(iacontext *ctx, iabenchmark step, iakv *kv) {
       if (rc != MDBX_NOTFOUND)
         goto bailout;
       rc = ENOENT;
+      break;
     }
+    kv->v = v.iov_base;
+    kv->vsize = v.iov_len;
     break;
 
   default:
@@ -415,14 +519,83 @@ bailout:
   return -1;
 }
 
+/* Sums up the free pages in the GC (aka freelist), each GC record is a list
+ * of page numbers prefixed by its length. This walks the whole GC within a
+ * read transaction, which holds a snapshot and so the reclaiming, thus it is
+ * not done by the sampler but at the end of a round only. Returns -1 when
+ * the walk fails. */
+static intmax_t ia_mdbx_gc_free(iaprivate *self) {
+  MDBX_txn *txn = NULL;
+  if (mdbx_txn_begin(self->env, NULL, MDBX_TXN_RDONLY, &txn) != MDBX_SUCCESS)
+    return -1;
+
+  intmax_t pages = 0;
+  MDBX_cursor *cursor = NULL;
+  int rc = mdbx_cursor_open(txn, 0 /* FREE_DBI */, &cursor);
+  if (rc == MDBX_SUCCESS) {
+    MDBX_val k, v;
+    while ((rc = mdbx_cursor_get(cursor, &k, &v, MDBX_NEXT)) == MDBX_SUCCESS)
+      if (v.iov_len >= sizeof(uint32_t))
+        pages += *(const uint32_t *)v.iov_base;
+    mdbx_cursor_close(cursor);
+  }
+  mdbx_txn_abort(txn);
+  return (rc == MDBX_NOTFOUND) ? pages : -1;
+}
+
+static int ia_mdbx_counters(iacounter *counters, int limit) {
+  iaprivate *self = ioarena.driver->priv;
+  if (!self || !self->env || limit < 6)
+    return 0;
+
+  MDBX_envinfo info;
+  MDBX_stat stat;
+  if (mdbx_env_info_ex(self->env, NULL, &info, sizeof(info)) != MDBX_SUCCESS ||
+      mdbx_env_stat_ex(self->env, NULL, &stat, sizeof(stat)) != MDBX_SUCCESS)
+    return 0;
+
+  const intmax_t gc_free = ia_histogram_sampling() ? -1 : ia_mdbx_gc_free(self);
+  counters[0].name = "size";
+  counters[0].value = info.mi_geo.current;
+  counters[0].cumulative = 0;
+  counters[1].name = "used";
+  counters[1].value = (info.mi_last_pgno + 1.0) * info.mi_dxb_pagesize;
+  counters[1].cumulative = 0;
+  counters[2].name = "gc_free";
+  counters[2].value =
+      (gc_free < 0) ? NAN : (double)gc_free * info.mi_dxb_pagesize;
+  counters[2].cumulative = 0;
+  counters[3].name = "depth";
+  counters[3].value = stat.ms_depth;
+  counters[3].cumulative = 0;
+  counters[4].name = "readers";
+  counters[4].value = info.mi_numreaders;
+  counters[4].cumulative = 0;
+  counters[5].name = "txns";
+  counters[5].value = info.mi_recent_txnid;
+  counters[5].cumulative = 1;
+  return 6;
+}
+
+static const char *ia_mdbx_version(void) {
+  static char version[64];
+  snprintf(version, sizeof(version), "%u.%u.%u.%u", mdbx_version.major,
+           mdbx_version.minor, mdbx_version.release, mdbx_version.revision);
+  return version;
+}
+
 iadriver ia_mdbx = {.name = "mdbx",
                     .priv = NULL,
                     .open = ia_mdbx_open,
                     .close = ia_mdbx_close,
+                    .version = ia_mdbx_version,
                     .option = ia_mdbx_option,
+                    .counters = ia_mdbx_counters,
+                    .reserve = 1,
 
                     .thread_new = ia_mdbx_thread_new,
                     .thread_dispose = ia_mdbx_thread_dispose,
                     .begin = ia_mdbx_begin,
                     .next = ia_mdbx_next,
+                    .seek = ia_mdbx_seek,
                     .done = ia_mdbx_done};
@@ -0,0 +1,536 @@
+﻿
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+/* not a database but a baseline, each write transaction is appended to
+ * a preallocated log file as block-aligned O_DIRECT write and then committed
+ * by fdatasync(). So the engines' sync-mode throughput could be shown as a
+ * fraction of the device's achievable commit rate. */
+
+#include "ioarena.h"
+
+#if HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/* a commit is waiting for the leader to write it, see ia_ring_commit() */
+struct ia_commit {
+  struct ia_commit *next;
+  const char *buf;
+  size_t len;
+  off_t offset;
+  int done, rc;
+};
+
+struct ia_ring {
+  int fd;
+  unsigned entries;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ptr, *cq_ptr;
+  size_t sq_len, cq_len, sqes_len;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int busy;
+  struct ia_commit *pending;
+};
+#endif /* HAVE_IO_URING */
+
+struct iaprivate {
+  int fd;
+  uintmax_t tail;
+  uintmax_t fsyncs, commits;
+#if HAVE_IO_URING
+  struct ia_ring ring;
+#endif
+};
+
+struct iacontext {
+  char *buf;
+  size_t size, used;
+};
+
+static struct {
+  intmax_t log_size, block, queue_depth;
+  int8_t direct, fill, io_uring;
+} globals = {.log_size = 1ll << 30, .block = 4096, .queue_depth = 64};
+
+static int ia_rawlog_option(iacontext *ctx, const char *arg) {
+  if (ctx)
+    return 0 /* no any non-global options */;
+
+  if (strcmp(arg, "--help") == 0) {
+    ia_log("  -o %s=<bytes> (default: 1G)", "LOG_SIZE");
+    ia_log("  -o %s=<bytes> (default: 4K)", "BLOCK");
+    ia_log("  -o %s=<ON|OFF> (default: ON)", "DIRECT");
+    ia_log("  -o %s=<ON|OFF> (default: OFF)", "FILL");
+    ia_log("  -o %s=<ON|OFF> (default: OFF)", "IO_URING");
+    ia_log("  -o %s=<number> (default: 64)", "QUEUE_DEPTH");
+    ia_log("     the log wraps around when full, FILL=ON zeroes it upfront "
+           "to avoid unwritten extents conversion on commit");
+    return 0;
+  }
+
+  int done = 0;
+  while (*arg && !done) {
+    const char *const prev = arg;
+    done = ia_parse_option_size(&arg, "LOG_SIZE", &globals.log_size);
+    if (!done)
+      done = ia_parse_option_size(&arg, "BLOCK", &globals.block);
+    if (!done)
+      done = ia_parse_option_bool(&arg, "DIRECT", &globals.direct);
+    if (!done)
+      done = ia_parse_option_bool(&arg, "FILL", &globals.fill);
+    if (!done)
+      done = ia_parse_option_bool(&arg, "IO_URING", &globals.io_uring);
+    if (!done)
+      done = ia_parse_option_size(&arg, "QUEUE_DEPTH", &globals.queue_depth);
+    if (!done && arg == prev)
+      break /* unknown option */;
+  }
+
+  if (done == 1)
+    return 0;
+  ia_log("%s: invalid option or value `%s`", "rawlog", arg);
+  return done ? done : -1;
+}
+
+#if HAVE_IO_URING
+static int ia_ring_init(struct ia_ring *ring, unsigned entries) {
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+  if (ring->fd < 0)
+    return errno;
+
+  ring->entries = p.sq_entries;
+  ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_len > ring->sq_len)
+      ring->sq_len = ring->cq_len;
+    ring->cq_len = 0;
+  }
+
+  ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED)
+    return errno;
+  ring->cq_ptr = ring->sq_ptr;
+  if (ring->cq_len) {
+    ring->cq_ptr =
+        mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED)
+      return errno;
+  }
+  ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED)
+    return errno;
+
+  char *sq = ring->sq_ptr, *cq = ring->cq_ptr;
+  ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+  ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+  ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+  pthread_mutex_init(&ring->mutex, NULL);
+  pthread_cond_init(&ring->cond, NULL);
+  return 0;
+}
+
+static void ia_ring_destroy(struct ia_ring *ring) {
+  if (ring->sqes && ring->sqes != MAP_FAILED)
+    munmap(ring->sqes, ring->sqes_len);
+  if (ring->cq_len && ring->cq_ptr && ring->cq_ptr != MAP_FAILED)
+    munmap(ring->cq_ptr, ring->cq_len);
+  if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED) {
+    munmap(ring->sq_ptr, ring->sq_len);
+    pthread_mutex_destroy(&ring->mutex);
+    pthread_cond_destroy(&ring->cond);
+  }
+  if (ring->fd > 0)
+    close(ring->fd);
+  memset(ring, 0, sizeof(*ring));
+}
+
+static struct io_uring_sqe *ia_ring_sqe(struct ia_ring *ring, unsigned nth) {
+  const unsigned index = (*ring->sq_tail + nth) & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[index] = index;
+  return sqe;
+}
+
+/* submits the batch and reaps all its completions, the fsync (if any)
+ * is the last one with zero user_data. */
+static int ia_ring_submit(struct ia_ring *ring, unsigned n) {
+  __atomic_store_n(ring->sq_tail, *ring->sq_tail + n, __ATOMIC_RELEASE);
+
+  int rc = 0;
+  unsigned submit = n, reaped = 0;
+  while (reaped < n) {
+    if (syscall(__NR_io_uring_enter, ring->fd, submit, n - reaped,
+                IORING_ENTER_GETEVENTS, NULL, 0) < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno;
+    }
+    submit = 0;
+
+    unsigned head = *ring->cq_head;
+    const unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head, ++reaped) {
+      const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+      struct ia_commit *commit = (struct ia_commit *)(uintptr_t)cqe->user_data;
+      int err = 0;
+      if (cqe->res < 0)
+        err = -cqe->res;
+      else if (commit && (size_t)cqe->res != commit->len)
+        err = EIO;
+      if (commit)
+        commit->rc = err;
+      else if (err && !rc)
+        rc = err;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  }
+  return rc;
+}
+
+/* writes a chain of commits, by a portions of up to the ring size.
+ * A lonely write is linked with the fsync, otherwise the fsync drains
+ * all the writes of the portion. */
+static int ia_ring_flush(iaprivate *self, struct ia_commit *chain, int sync) {
+  struct ia_ring *ring = &self->ring;
+  int rc = 0;
+  while (chain) {
+    struct ia_commit *first = chain;
+    unsigned n = 0;
+    while (chain && n < ring->entries - sync) {
+      struct io_uring_sqe *sqe = ia_ring_sqe(ring, n++);
+      sqe->opcode = IORING_OP_WRITE;
+      sqe->fd = self->fd;
+      sqe->addr = (uintptr_t)chain->buf;
+      sqe->len = chain->len;
+      sqe->off = chain->offset;
+      sqe->user_data = (uintptr_t)chain;
+      chain = chain->next;
+    }
+    if (sync) {
+      if (n == 1)
+        ring->sqes[*ring->sq_tail & *ring->sq_mask].flags |= IOSQE_IO_LINK;
+      struct io_uring_sqe *sqe = ia_ring_sqe(ring, n++);
+      sqe->opcode = IORING_OP_FSYNC;
+      sqe->fd = self->fd;
+      sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+      sqe->flags = IOSQE_IO_DRAIN;
+      __sync_fetch_and_add(&self->fsyncs, 1);
+    }
+
+    rc = ia_ring_submit(ring, n);
+    for (; first != chain; first = first->next)
+      if (rc && !first->rc)
+        first->rc = rc;
+  }
+  return rc;
+}
+
+/* a group commit, the first thread which finds the ring idle becomes
+ * a leader and writes all the pending commits by a single submission,
+ * while the others wait for it. */
+static int ia_ring_commit(iaprivate *self, struct ia_commit *mine, int sync) {
+  struct ia_ring *ring = &self->ring;
+  pthread_mutex_lock(&ring->mutex);
+  mine->next = ring->pending;
+  ring->pending = mine;
+  while (!mine->done) {
+    if (ring->busy) {
+      pthread_cond_wait(&ring->cond, &ring->mutex);
+      continue;
+    }
+    struct ia_commit *chain = ring->pending;
+    ring->pending = NULL;
+    ring->busy = 1;
+    pthread_mutex_unlock(&ring->mutex);
+
+    ia_ring_flush(self, chain, sync);
+
+    pthread_mutex_lock(&ring->mutex);
+    for (; chain; chain = chain->next)
+      chain->done = 1;
+    ring->busy = 0;
+    pthread_cond_broadcast(&ring->cond);
+  }
+  pthread_mutex_unlock(&ring->mutex);
+  return mine->rc;
+}
+#endif /* HAVE_IO_URING */
+
+static int ia_rawlog_fill(int fd, intmax_t size) {
+  const size_t chunk = 1 << 20;
+  void *zeros;
+  int rc = posix_memalign(&zeros, globals.block, chunk);
+  if (rc)
+    return rc;
+  memset(zeros, 0, chunk);
+  for (intmax_t offset = 0; offset < size; offset += chunk) {
+    size_t len = chunk;
+    if (size - offset < (intmax_t)chunk)
+      len = size - offset;
+    if (pwrite(fd, zeros, len, offset) != (ssize_t)len) {
+      rc = errno ? errno : EIO;
+      break;
+    }
+  }
+  free(zeros);
+  if (!rc && fdatasync(fd))
+    rc = errno;
+  return rc;
+}
+
+static int ia_rawlog_open(const char *datadir) {
+  iadriver *drv = ioarena.driver;
+  char path[PATH_MAX];
+  int rc;
+
+  if (globals.block < 512 || (globals.block & (globals.block - 1)) ||
+      globals.log_size < globals.block) {
+    ia_log("%s: BLOCK must be a power of two not less than 512, "
+           "and LOG_SIZE at least one block",
+           "rawlog");
+    return -1;
+  }
+  globals.log_size -= globals.log_size % globals.block;
+#if !HAVE_IO_URING
+  if (globals.io_uring == ia_opt_bool_on) {
+    ia_log("%s: io_uring isn't available in this build", "rawlog");
+    return -1;
+  }
+#endif
+
+  iaprivate *self = calloc(1, sizeof(iaprivate));
+  if (self == NULL)
+    return ENOMEM;
+  drv->priv = self;
+  self->fd = -1;
+
+  int flags = O_RDWR | O_CREAT;
+  if (globals.direct != ia_opt_bool_off)
+    flags |= O_DIRECT;
+  snprintf(path, sizeof(path), "%s/rawlog", datadir);
+  self->fd = open(path, flags, 0644);
+  if (self->fd < 0) {
+    rc = errno;
+    ia_log("%s: open(%s), %s%s", "rawlog", path, strerror(rc),
+           (rc == EINVAL) ? ", try -o DIRECT=OFF" : "");
+    goto bailout;
+  }
+
+  rc = posix_fallocate(self->fd, 0, globals.log_size);
+  if (rc) {
+    ia_log("%s: posix_fallocate(%jd), %s", "rawlog", globals.log_size,
+           strerror(rc));
+    goto bailout;
+  }
+  if (globals.fill == ia_opt_bool_on) {
+    rc = ia_rawlog_fill(self->fd, globals.log_size);
+    if (rc) {
+      ia_log("%s: fill, %s", "rawlog", strerror(rc));
+      goto bailout;
+    }
+  }
+
+#if HAVE_IO_URING
+  if (globals.io_uring == ia_opt_bool_on) {
+    rc = ia_ring_init(&self->ring, (unsigned)globals.queue_depth);
+    if (rc) {
+      ia_log("%s: io_uring setup, %s", "rawlog", strerror(rc));
+      goto bailout;
+    }
+  }
+#endif
+  return 0;
+
+bailout:
+  drv->close();
+  return rc ? rc : -1;
+}
+
+static int ia_rawlog_close(void) {
+  iadriver *drv = ioarena.driver;
+  iaprivate *self = drv->priv;
+  if (self) {
+    drv->priv = NULL;
+#if HAVE_IO_URING
+    ia_ring_destroy(&self->ring);
+#endif
+    if (self->fd >= 0) {
+      if (ioarena.conf.syncmode == IA_LAZY)
+        fdatasync(self->fd);
+      close(self->fd);
+    }
+    free(self);
+  }
+  return 0;
+}
+
+static iacontext *ia_rawlog_thread_new(void) {
+  iacontext *ctx = calloc(1, sizeof(iacontext));
+  return ctx;
+}
+
+static void ia_rawlog_thread_dispose(iacontext *ctx) {
+  free(ctx->buf);
+  free(ctx);
+}
+
+static int ia_rawlog_begin(iacontext *ctx, iabenchmark step) {
+  switch (step) {
+  case IA_SET:
+  case IA_DELETE:
+    ctx->used = 0;
+    return 0;
+
+  case IA_BATCH:
+  case IA_CRUD:
+  case IA_ITERATE:
+  case IA_GET:
+    ia_log("%s: there is nothing to %s, only set and delete are supported",
+           "rawlog", ia_benchmarkof(step));
+    return -1;
+
+  default:
+    assert(0);
+    return -1;
+  }
+}
+
+static int ia_rawlog_reserve(iacontext *ctx, size_t len) {
+  size_t size = ctx->size ? ctx->size : (size_t)globals.block;
+  while (size < ctx->used + len)
+    size += size;
+  if (size == ctx->size)
+    return 0;
+
+  void *buf;
+  int rc = posix_memalign(&buf, globals.block, size);
+  if (rc)
+    return rc;
+  if (ctx->used)
+    memcpy(buf, ctx->buf, ctx->used);
+  free(ctx->buf);
+  ctx->buf = buf;
+  ctx->size = size;
+  return 0;
+}
+
+static int ia_rawlog_next(iacontext *ctx, iabenchmark step, iakv *kv) {
+  const uint32_t vsize = (step == IA_DELETE) ? UINT32_MAX : kv->vsize;
+  const size_t len = sizeof(uint32_t) * 2 + kv->ksize +
+                     ((step == IA_DELETE) ? 0 : kv->vsize);
+  int rc = ia_rawlog_reserve(ctx, len);
+  if (rc)
+    return rc;
+
+  uint32_t header[2] = {kv->ksize, vsize};
+  char *p = ctx->buf + ctx->used;
+  memcpy(p, header, sizeof(header));
+  memcpy(p + sizeof(header), kv->k, kv->ksize);
+  if (step != IA_DELETE && kv->v)
+    memcpy(p + sizeof(header) + kv->ksize, kv->v, kv->vsize);
+  else if (step != IA_DELETE && kv->vsize)
+    ia_kv_value(kv, p + sizeof(header) + kv->ksize);
+  ctx->used += len;
+  return 0;
+}
+
+static int ia_rawlog_done(iacontext *ctx, iabenchmark step) {
+  iaprivate *self = ioarena.driver->priv;
+  (void)step;
+  if (ctx->used == 0)
+    return 0;
+
+  const size_t len = (ctx->used + globals.block - 1) & ~(globals.block - 1);
+  if ((intmax_t)len > globals.log_size)
+    return EFBIG;
+  memset(ctx->buf + ctx->used, 0, len - ctx->used);
+  ctx->used = 0;
+
+  /* the content is never read back, so the log just wraps around */
+  off_t offset = __sync_fetch_and_add(&self->tail, len) % globals.log_size;
+  if (offset + (intmax_t)len > globals.log_size)
+    offset = 0;
+  __sync_fetch_and_add(&self->commits, 1);
+  const int sync = ioarena.conf.syncmode == IA_SYNC;
+
+#if HAVE_IO_URING
+  if (self->ring.sq_ptr) {
+    struct ia_commit commit = {
+        .buf = ctx->buf, .len = len, .offset = offset, .done = 0, .rc = 0};
+    return ia_ring_commit(self, &commit, sync);
+  }
+#endif
+
+  if (pwrite(self->fd, ctx->buf, len, offset) != (ssize_t)len)
+    return errno ? errno : EIO;
+  if (sync) {
+    __sync_fetch_and_add(&self->fsyncs, 1);
+    if (fdatasync(self->fd))
+      return errno;
+  }
+  return 0;
+}
+
+static int ia_rawlog_counters(iacounter *counters, int limit) {
+  iaprivate *self = ioarena.driver->priv;
+  if (!self || limit < 2)
+    return 0;
+
+  counters[0].name = "commits";
+  counters[0].value = self->commits;
+  counters[0].cumulative = 1;
+  counters[1].name = "fsync";
+  counters[1].value = self->fsyncs;
+  counters[1].cumulative = 1;
+  return 2;
+}
+
+static const char *ia_rawlog_version(void) {
+  iaprivate *self = ioarena.driver->priv;
+#if HAVE_IO_URING
+  if (self && self->ring.sq_ptr)
+    return "io_uring";
+#endif
+  (void)self;
+  return (globals.direct != ia_opt_bool_off) ? "pwrite+o_direct" : "pwrite";
+}
+
+iadriver ia_rawlog = {.name = "rawlog",
+                      .priv = NULL,
+                      .open = ia_rawlog_open,
+                      .close = ia_rawlog_close,
+                      .option = ia_rawlog_option,
+                      .version = ia_rawlog_version,
+                      .counters = ia_rawlog_counters,
+                      .reserve = 1,
+
+                      .thread_new = ia_rawlog_thread_new,
+                      .thread_dispose = ia_rawlog_thread_dispose,
+                      .begin = ia_rawlog_begin,
+                      .next = ia_rawlog_next,
+                      .done = ia_rawlog_done};
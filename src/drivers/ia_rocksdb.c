@@ -10,6 +10,7 @@
 #include "rocksdb/c.h"
 
 struct iaprivate {
+  rocksdb_cache_t *cache;
   rocksdb_options_t *opts;
   rocksdb_readoptions_t *ropts;
   rocksdb_writeoptions_t *wopts;
@@ -19,23 +20,377 @@ struct iaprivate {
 struct iacontext {
   rocksdb_iterator_t *it;
   rocksdb_writebatch_t *batch;
+  /* of crud and batch, which read their own writes */
+  rocksdb_writebatch_wi_t *indexed;
   char *result;
+  rocksdb_pinnableslice_t *pinned;
 };
 
+#define UNSET -1
+
+static const char *const profiles[] = {"default", "point-lookup",
+                                       "write-heavy", NULL};
+enum { CACHE_LRU, CACHE_HYPERCLOCK };
+static const char *const cache_types[] = {"lru", "hyperclock", NULL};
+static const char *const compaction_styles[] = {"level", "universal", "fifo",
+                                                NULL};
+enum { MEMTABLE_SKIPLIST, MEMTABLE_VECTOR, MEMTABLE_HASH_SKIPLIST,
+       MEMTABLE_HASH_LINKLIST };
+static const char *const memtable_types[] = {
+    "skiplist", "vector", "hash-skiplist", "hash-linklist", NULL};
+/* in the order of rocksdb_*_compression values */
+static const char *const compression_codecs[] = {
+    "none", "snappy", "zlib", "bz2", "lz4", "lz4hc", "xpress", "zstd", NULL};
+
+struct rocksdb_opts {
+  int8_t pinned;
+  int8_t direct_io;
+  int8_t merge;
+  int8_t fill_cache;
+  int profile;
+  int cache_type;
+  int compaction;
+  int memtable;
+  int compression;
+  intmax_t cache_size;
+  intmax_t bloom_bits;
+  intmax_t write_buffer;
+  intmax_t bg_jobs;
+};
+
+static struct rocksdb_opts globals = {.profile = UNSET,
+                                      .cache_type = UNSET,
+                                      .compaction = UNSET,
+                                      .memtable = UNSET,
+                                      .compression = UNSET,
+                                      .cache_size = UNSET,
+                                      .bloom_bits = UNSET,
+                                      .write_buffer = UNSET,
+                                      .bg_jobs = UNSET};
+
+/* the values of a profile are used for the options which are not given
+ * explicitly, UNSET here means the rocksdb's own default. */
+static const struct rocksdb_opts presets[] = {
+    /* default, i.e. no compression and default cache without filters */
+    {.cache_type = CACHE_LRU,
+     .compaction = 0 /* level */,
+     .memtable = MEMTABLE_SKIPLIST,
+     .compression = 0 /* none */,
+     .cache_size = UNSET,
+     .bloom_bits = 0,
+     .write_buffer = UNSET,
+     .bg_jobs = UNSET},
+    /* point-lookup */
+    {.cache_type = CACHE_HYPERCLOCK,
+     .compaction = 0 /* level */,
+     .memtable = MEMTABLE_SKIPLIST,
+     .compression = 4 /* lz4 */,
+     .cache_size = (intmax_t)1 << 30,
+     .bloom_bits = 10,
+     .write_buffer = UNSET,
+     .bg_jobs = UNSET},
+    /* write-heavy */
+    {.cache_type = CACHE_LRU,
+     .compaction = 1 /* universal */,
+     .memtable = MEMTABLE_SKIPLIST,
+     .compression = 4 /* lz4 */,
+     .cache_size = UNSET,
+     .bloom_bits = 10,
+     .write_buffer = (intmax_t)256 << 20,
+     .bg_jobs = 8}};
+
+static int ia_rocksdb_option(iacontext *ctx, const char *arg) {
+  if (ctx)
+    return 0 /* no any non-global options */;
+
+  if (strcmp(arg, "--help") == 0) {
+    ia_log("  -o %s=<ON|OFF>                (default: ON)", "PINNED");
+    ia_log("     zero-copy gets by rocksdb_get_pinned(), "
+           "otherwise by rocksdb_get()");
+    ia_log("  -o %s=<name>                 (default: default)", "PROFILE");
+    ia_log("     choices: default, point-lookup, write-heavy");
+    ia_log("     point-lookup is 1G hyperclock cache, bloom 10 and lz4, "
+           "write-heavy is universal");
+    ia_log("     compaction, 256M write buffer, 8 bg jobs, bloom 10 and lz4");
+    ia_log("  -o %s=<bytes>                  (block cache, 0 to disable)",
+           "CACHE");
+    ia_log("  -o %s=<type>              (default: lru)", "CACHE_TYPE");
+    ia_log("     choices: lru, hyperclock");
+    ia_log("  -o %s=<ON|OFF>            (default: ON)", "FILL_CACHE");
+    ia_log("     the reads populate the block cache, OFF to measure the "
+           "uncached path");
+    ia_log("  -o %s=<bits_per_key>           (0 to disable)", "BLOOM");
+    ia_log("  -o %s=<style>             (default: level)", "COMPACTION");
+    ia_log("     choices: level, universal, fifo");
+    ia_log("  -o %s=<type>                (default: skiplist)", "MEMTABLE");
+    ia_log("     choices: skiplist, vector, hash-skiplist, hash-linklist");
+    ia_log("  -o %s=<bytes>           (memtable size)", "WRITE_BUFFER");
+    ia_log("  -o %s=<number>                (max background jobs)",
+           "BG_JOBS");
+    ia_log("  -o %s=<ON|OFF>             (default: OFF)", "DIRECT_IO");
+    ia_log("  -o %s=<ON|OFF>                 (default: OFF)", "MERGE");
+    ia_log("     the update benchmark by rocksdb_merge() instead of "
+           "get and put");
+    ia_log("  -o %s=<codec>            (default: none)", "COMPRESSION");
+    ia_log("     choices: none, snappy, zlib, bz2, lz4, lz4hc, xpress, zstd");
+    ia_log("     sizes could be given with K, M, G or T suffix");
+    return 0;
+  }
+
+  int done = 0;
+  while (*arg && !done) {
+    const char *const prev = arg;
+    done = ia_parse_option_bool(&arg, "PINNED", &globals.pinned);
+    if (!done)
+      done = ia_parse_option_bool(&arg, "DIRECT_IO", &globals.direct_io);
+    if (!done)
+      done = ia_parse_option_bool(&arg, "MERGE", &globals.merge);
+    if (!done)
+      done = ia_parse_option_bool(&arg, "FILL_CACHE", &globals.fill_cache);
+    if (!done)
+      done = ia_parse_option_enum(&arg, "PROFILE", profiles, &globals.profile);
+    if (!done)
+      done = ia_parse_option_enum(&arg, "CACHE_TYPE", cache_types,
+                                  &globals.cache_type);
+    if (!done)
+      done = ia_parse_option_enum(&arg, "COMPACTION", compaction_styles,
+                                  &globals.compaction);
+    if (!done)
+      done = ia_parse_option_enum(&arg, "MEMTABLE", memtable_types,
+                                  &globals.memtable);
+    if (!done)
+      done = ia_parse_option_enum(&arg, "COMPRESSION", compression_codecs,
+                                  &globals.compression);
+    if (!done)
+      done = ia_parse_option_size(&arg, "CACHE", &globals.cache_size);
+    if (!done)
+      done = ia_parse_option_size(&arg, "BLOOM", &globals.bloom_bits);
+    if (!done)
+      done = ia_parse_option_size(&arg, "WRITE_BUFFER", &globals.write_buffer);
+    if (!done)
+      done = ia_parse_option_size(&arg, "BG_JOBS", &globals.bg_jobs);
+    if (!done && arg == prev)
+      break /* unknown option */;
+  }
+
+  if (done == 1)
+    return 0;
+  ia_log("%s: invalid option or value `%s`", "rocksdb", arg);
+  return done ? done : -1;
+}
+
+/* the value of the previous get must stay valid until the next one,
+ * since it is referenced by the iakv, but should not be held longer. */
+static void ia_rocksdb_release(iacontext *ctx) {
+  if (ctx->result) {
+    free(ctx->result);
+    ctx->result = NULL;
+  }
+  if (ctx->pinned) {
+    rocksdb_pinnableslice_destroy(ctx->pinned);
+    ctx->pinned = NULL;
+  }
+}
+
+static intmax_t peek_option(intmax_t value, intmax_t preset) {
+  return (value != UNSET) ? value : preset;
+}
+
+static void ia_rocksdb_tune(iaprivate *self) {
+  const struct rocksdb_opts *preset =
+      &presets[peek_option(globals.profile, 0)];
+  const int cache_type = peek_option(globals.cache_type, preset->cache_type);
+  const int compaction = peek_option(globals.compaction, preset->compaction);
+  const int memtable = peek_option(globals.memtable, preset->memtable);
+  const int compression =
+      peek_option(globals.compression, preset->compression);
+  const intmax_t cache_size =
+      peek_option(globals.cache_size, preset->cache_size);
+  const intmax_t bloom_bits =
+      peek_option(globals.bloom_bits, preset->bloom_bits);
+  const intmax_t write_buffer =
+      peek_option(globals.write_buffer, preset->write_buffer);
+  const intmax_t bg_jobs = peek_option(globals.bg_jobs, preset->bg_jobs);
+
+  rocksdb_options_set_compression(self->opts, compression);
+  rocksdb_options_set_compaction_style(self->opts, compaction);
+  if (write_buffer > 0)
+    rocksdb_options_set_write_buffer_size(self->opts, write_buffer);
+  if (bg_jobs > 0)
+    rocksdb_options_set_max_background_jobs(self->opts, (int)bg_jobs);
+  if (globals.direct_io == ia_opt_bool_on) {
+    rocksdb_options_set_use_direct_reads(self->opts, 1);
+    rocksdb_options_set_use_direct_io_for_flush_and_compaction(self->opts, 1);
+  }
+
+  switch (memtable) {
+  case MEMTABLE_VECTOR:
+    rocksdb_options_set_memtable_vector_rep(self->opts);
+    break;
+  case MEMTABLE_HASH_SKIPLIST:
+  case MEMTABLE_HASH_LINKLIST:
+    /* hash-based memtables are indexed by a key prefix */
+    rocksdb_options_set_prefix_extractor(
+        self->opts, rocksdb_slicetransform_create_fixed_prefix(
+                        ioarena.conf.ksize < 8 ? ioarena.conf.ksize : 8));
+    if (memtable == MEMTABLE_HASH_SKIPLIST)
+      rocksdb_options_set_hash_skip_list_rep(self->opts, 1000000, 4, 4);
+    else
+      rocksdb_options_set_hash_link_list_rep(self->opts, 1000000);
+    break;
+  }
+  if (memtable != MEMTABLE_SKIPLIST)
+    rocksdb_options_set_allow_concurrent_memtable_write(self->opts, 0);
+
+  rocksdb_block_based_table_options_t *table =
+      rocksdb_block_based_options_create();
+  if (cache_size == 0)
+    rocksdb_block_based_options_set_no_block_cache(table, 1);
+  else if (cache_size > 0) {
+    self->cache = (cache_type == CACHE_HYPERCLOCK)
+                      ? rocksdb_cache_create_hyper_clock(cache_size, 4096)
+                      : rocksdb_cache_create_lru(cache_size);
+    rocksdb_block_based_options_set_block_cache(table, self->cache);
+  }
+  if (bloom_bits > 0)
+    rocksdb_block_based_options_set_filter_policy(
+        table, rocksdb_filterpolicy_create_bloom_full(bloom_bits));
+  rocksdb_options_set_block_based_table_factory(self->opts, table);
+  rocksdb_block_based_options_destroy(table);
+
+  ia_log("rocksdb: profile %s, cache %s %jd, bloom %jd, compaction %s, "
+         "memtable %s %jd, jobs %jd, compression %s, direct-io %s",
+         profiles[peek_option(globals.profile, 0)], cache_types[cache_type],
+         cache_size, bloom_bits, compaction_styles[compaction],
+         memtable_types[memtable], write_buffer, bg_jobs,
+         compression_codecs[compression],
+         (globals.direct_io == ia_opt_bool_on) ? "on" : "off");
+}
+
+/* an operand of the update's merge, the bytes in [offset, offset + length)
+ * are incremented. The operands aren't combined by the partial merge, since
+ * the slices differ. */
+struct ia_rocksdb_patch {
+  uint32_t offset, length;
+};
+
+static char *ia_rocksdb_full_merge(void *state, const char *key,
+                                   size_t key_length, const char *existing,
+                                   size_t existing_length,
+                                   const char *const *operands,
+                                   const size_t *operands_length,
+                                   int num_operands, unsigned char *success,
+                                   size_t *new_length) {
+  (void)state;
+  (void)key;
+  (void)key_length;
+  size_t length = existing ? existing_length : 0;
+  for (int i = 0; i < num_operands; ++i) {
+    struct ia_rocksdb_patch patch;
+    if (operands_length[i] != sizeof(patch))
+      goto bailout;
+    memcpy(&patch, operands[i], sizeof(patch));
+    if (length < (size_t)patch.offset + patch.length)
+      length = (size_t)patch.offset + patch.length;
+  }
+
+  char *value = calloc(1, length ? length : 1);
+  if (!value)
+    goto bailout;
+  if (existing)
+    memcpy(value, existing, existing_length);
+  for (int i = 0; i < num_operands; ++i) {
+    struct ia_rocksdb_patch patch;
+    memcpy(&patch, operands[i], sizeof(patch));
+    for (size_t j = patch.offset; j < (size_t)patch.offset + patch.length; ++j)
+      value[j] += 1;
+  }
+  *new_length = length;
+  *success = 1;
+  return value;
+
+bailout:
+  *success = 0;
+  return NULL;
+}
+
+static char *ia_rocksdb_partial_merge(void *state, const char *key,
+                                      size_t key_length,
+                                      const char *const *operands,
+                                      const size_t *operands_length,
+                                      int num_operands, unsigned char *success,
+                                      size_t *new_length) {
+  (void)state;
+  (void)key;
+  (void)key_length;
+  (void)operands;
+  (void)operands_length;
+  (void)num_operands;
+  (void)new_length;
+  *success = 0;
+  return NULL;
+}
+
+static void ia_rocksdb_merge_free(void *state, const char *value,
+                                  size_t length) {
+  (void)state;
+  (void)length;
+  free((void *)value);
+}
+
+static void ia_rocksdb_merge_destroy(void *state) { (void)state; }
+
+static const char *ia_rocksdb_merge_name(void *state) {
+  (void)state;
+  return "ioarena.update";
+}
+
+static int ia_rocksdb_merge(iacontext *ctx, iakv *kv, size_t offset,
+                            size_t length) {
+  iaprivate *self = ioarena.driver->priv;
+  if (globals.merge != ia_opt_bool_on)
+    return ENOSYS;
+
+  struct ia_rocksdb_patch patch = {.offset = offset, .length = length};
+  char *error = NULL;
+  if (ctx->indexed)
+    rocksdb_writebatch_wi_merge(ctx->indexed, kv->k, kv->ksize,
+                                (const char *)&patch, sizeof(patch));
+  else if (ctx->batch)
+    rocksdb_writebatch_merge(ctx->batch, kv->k, kv->ksize,
+                             (const char *)&patch, sizeof(patch));
+  else
+    rocksdb_merge(self->db, self->wopts, kv->k, kv->ksize,
+                  (const char *)&patch, sizeof(patch), &error);
+  if (error) {
+    ia_log("error: %s, %s", __func__, error);
+    free(error);
+    return -1;
+  }
+  return 0;
+}
+
 static int ia_rocksdb_open(const char *datadir) {
   iadriver *drv = ioarena.driver;
-  drv->priv = malloc(sizeof(iaprivate));
+  drv->priv = calloc(1, sizeof(iaprivate));
   if (drv->priv == NULL)
     return -1;
 
   iaprivate *self = drv->priv;
   self->opts = rocksdb_options_create();
-  rocksdb_options_set_compression(self->opts, rocksdb_no_compression);
+  ia_rocksdb_tune(self);
   rocksdb_options_set_info_log(self->opts, NULL);
   rocksdb_options_set_create_if_missing(self->opts, 1);
+  if (globals.merge == ia_opt_bool_on)
+    rocksdb_options_set_merge_operator(
+        self->opts, rocksdb_mergeoperator_create(
+                        NULL, ia_rocksdb_merge_destroy, ia_rocksdb_full_merge,
+                        ia_rocksdb_partial_merge, ia_rocksdb_merge_free,
+                        ia_rocksdb_merge_name));
   self->wopts = rocksdb_writeoptions_create();
   self->ropts = rocksdb_readoptions_create();
-  rocksdb_readoptions_set_fill_cache(self->ropts, 0);
+  rocksdb_readoptions_set_fill_cache(self->ropts,
+                                     globals.fill_cache != ia_opt_bool_off);
 
   /* LY: suggestions are welcome */
   switch (ioarena.conf.syncmode) {
@@ -94,18 +449,21 @@ static int ia_rocksdb_close(void) {
       rocksdb_writeoptions_destroy(self->wopts);
     if (self->opts)
       rocksdb_options_destroy(self->opts);
+    if (self->cache)
+      rocksdb_cache_destroy(self->cache);
     free(self);
   }
   return 0;
 }
 
 static void ia_rocksdb_thread_dispose(iacontext *ctx) {
-  if (ctx->result)
-    free(ctx->result);
+  ia_rocksdb_release(ctx);
   if (ctx->it)
     rocksdb_iter_destroy(ctx->it);
   if (ctx->batch)
     rocksdb_writebatch_destroy(ctx->batch);
+  if (ctx->indexed)
+    rocksdb_writebatch_wi_destroy(ctx->indexed);
   free(ctx);
 }
 
@@ -121,8 +479,6 @@ static int ia_rocksdb_begin(iacontext *ctx, iabenchmark step) {
 
   switch (step) {
   case IA_GET:
-  case IA_SET:
-  case IA_DELETE:
     break;
 
   case IA_ITERATE:
@@ -134,8 +490,10 @@ static int ia_rocksdb_begin(iacontext *ctx, iabenchmark step) {
     rocksdb_iter_seek_to_first(ctx->it);
     break;
 
-  case IA_BATCH:
-  case IA_CRUD:
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2)
+      break;
     ctx->batch = rocksdb_writebatch_create();
     if (!ctx->batch) {
       error = "rocksdb_writebatch_create() failed";
@@ -143,6 +501,16 @@ static int ia_rocksdb_begin(iacontext *ctx, iabenchmark step) {
     }
     break;
 
+  case IA_BATCH:
+  case IA_CRUD:
+    /* the gets have to see the writes of the same batch */
+    ctx->indexed = rocksdb_writebatch_wi_create(0, 1);
+    if (!ctx->indexed) {
+      error = "rocksdb_writebatch_wi_create() failed";
+      goto bailout;
+    }
+    break;
+
   default:
     assert(0);
     rc = -1;
@@ -162,12 +530,7 @@ static int ia_rocksdb_done(iacontext *ctx, iabenchmark step) {
 
   switch (step) {
   case IA_GET:
-    if (ctx->result) {
-      free(ctx->result);
-      ctx->result = NULL;
-    }
-  case IA_SET:
-  case IA_DELETE:
+    ia_rocksdb_release(ctx);
     break;
 
   case IA_ITERATE:
@@ -177,6 +540,8 @@ static int ia_rocksdb_done(iacontext *ctx, iabenchmark step) {
     }
     break;
 
+  case IA_SET:
+  case IA_DELETE:
   case IA_CRUD:
   case IA_BATCH:
     if (ctx->batch) {
@@ -186,6 +551,13 @@ static int ia_rocksdb_done(iacontext *ctx, iabenchmark step) {
       rocksdb_writebatch_destroy(ctx->batch);
       ctx->batch = NULL;
     }
+    if (ctx->indexed) {
+      rocksdb_write_writebatch_wi(self->db, self->wopts, ctx->indexed, &error);
+      if (error != NULL)
+        goto bailout;
+      rocksdb_writebatch_wi_destroy(ctx->indexed);
+      ctx->indexed = NULL;
+    }
     break;
 
   default:
@@ -201,6 +573,11 @@ bailout:
   return -1;
 }
 
+static int ia_rocksdb_seek(iacontext *ctx, iakv *kv) {
+  rocksdb_iter_seek(ctx->it, kv->k, kv->ksize);
+  return rocksdb_iter_valid(ctx->it) ? 0 : ENOENT;
+}
+
 static int ia_rocksdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   iaprivate *self = ioarena.driver->priv;
   int rc = 0;
@@ -208,7 +585,10 @@ static int ia_rocksdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
 
   switch (step) {
   case IA_SET:
-    if (ctx->batch)
+    if (ctx->indexed)
+      rocksdb_writebatch_wi_put(ctx->indexed, kv->k, kv->ksize, kv->v,
+                                kv->vsize);
+    else if (ctx->batch)
       rocksdb_writebatch_put(ctx->batch, kv->k, kv->ksize, kv->v, kv->vsize);
     else
       rocksdb_put(self->db, self->wopts, kv->k, kv->ksize, kv->v, kv->vsize,
@@ -219,7 +599,9 @@ static int ia_rocksdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     break;
 
   case IA_DELETE:
-    if (ctx->batch)
+    if (ctx->indexed)
+      rocksdb_writebatch_wi_delete(ctx->indexed, kv->k, kv->ksize);
+    else if (ctx->batch)
       rocksdb_writebatch_delete(ctx->batch, kv->k, kv->ksize);
     else
       rocksdb_delete(self->db, self->wopts, kv->k, kv->ksize, &error);
@@ -228,19 +610,33 @@ static int ia_rocksdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     break;
 
   case IA_GET:
-    if (ctx->result)
-      free(ctx->result);
-    ctx->result = rocksdb_get(self->db, self->ropts, kv->k, kv->ksize,
-                              &kv->vsize, &error);
-    if (error)
-      goto bailout;
-    if (!ctx->result) {
-      if (!ctx->batch) /* TODO: rework to avoid */ {
-        rc = ENOENT;
-        break;
-      }
+    ia_rocksdb_release(ctx);
+    if (ctx->indexed) {
+      ctx->result = rocksdb_writebatch_wi_get_from_batch_and_db(
+          ctx->indexed, self->db, self->ropts, kv->k, kv->ksize, &kv->vsize,
+          &error);
+      if (error)
+        goto bailout;
+      kv->v = ctx->result;
+    } else if (globals.pinned != ia_opt_bool_off) {
+      ctx->pinned =
+          rocksdb_get_pinned(self->db, self->ropts, kv->k, kv->ksize, &error);
+      if (error)
+        goto bailout;
+      kv->v = ctx->pinned ? (char *)rocksdb_pinnableslice_value(ctx->pinned,
+                                                                 &kv->vsize)
+                          : NULL;
+    } else {
+      ctx->result = rocksdb_get(self->db, self->ropts, kv->k, kv->ksize,
+                                &kv->vsize, &error);
+      if (error)
+        goto bailout;
+      kv->v = ctx->result;
+    }
+    if (!kv->v) {
+      kv->vsize = 0;
+      rc = ENOENT;
     }
-    kv->v = ctx->result;
     break;
 
   case IA_ITERATE:
@@ -263,13 +659,97 @@ bailout:
   return -1;
 }
 
+static double ia_rocksdb_property(iaprivate *self, const char *name) {
+  uint64_t value;
+  return rocksdb_property_int(self->db, name, &value) ? NAN : (double)value;
+}
+
+/* picks a number that follows the given text within the rocksdb's
+ * human-readable stats, e.g. "Flush(GB): cumulative 0.123" */
+static double ia_rocksdb_scan(const char *stats, const char *text) {
+  const char *found = stats ? strstr(stats, text) : NULL;
+  return found ? strtod(found + strlen(text), NULL) : NAN;
+}
+
+static int ia_rocksdb_counters(iacounter *counters, int limit) {
+  iaprivate *self = ioarena.driver->priv;
+  if (!self || !self->db || limit < 8)
+    return 0;
+
+  const double giga = 1 << 30;
+  char *l0 = rocksdb_property_value(self->db, "rocksdb.num-files-at-level0");
+  char *db = rocksdb_property_value(self->db, "rocksdb.dbstats");
+  char *cf = rocksdb_property_value(self->db, "rocksdb.cfstats");
+  char *sst =
+      rocksdb_property_value(self->db, "rocksdb.aggregated-table-properties");
+
+  double stall = NAN;
+  const char *found = db ? strstr(db, "Cumulative stall:") : NULL;
+  int hours, minutes;
+  double seconds;
+  if (found && sscanf(found, "Cumulative stall: %d:%d:%lf", &hours, &minutes,
+                      &seconds) == 3)
+    stall = ((hours * 60 + minutes) * 60 + seconds) * 1e6;
+
+  const double ingest = ia_rocksdb_scan(db, "ingest: ");
+  const double flushed = ia_rocksdb_scan(cf, "Flush(GB): cumulative ");
+  const double compacted = ia_rocksdb_scan(cf, "Cumulative compaction: ");
+  const double raw = ia_rocksdb_scan(sst, "raw key size=") +
+                     ia_rocksdb_scan(sst, "raw value size=");
+  const double stored = ia_rocksdb_scan(sst, "data block size=");
+
+  counters[0].name = "pending";
+  counters[0].value =
+      ia_rocksdb_property(self, "rocksdb.estimate-pending-compaction-bytes");
+  counters[0].cumulative = 0;
+  counters[1].name = "l0";
+  counters[1].value = l0 ? strtod(l0, NULL) : NAN;
+  counters[1].cumulative = 0;
+  counters[2].name = "compacting";
+  counters[2].value =
+      ia_rocksdb_property(self, "rocksdb.num-running-compactions");
+  counters[2].cumulative = 0;
+  counters[3].name = "delayed";
+  counters[3].value =
+      ia_rocksdb_property(self, "rocksdb.actual-delayed-write-rate");
+  counters[3].cumulative = 0;
+  counters[4].name = "stall_us";
+  counters[4].value = stall;
+  counters[4].cumulative = 1;
+  counters[5].name = "flushed";
+  counters[5].value = flushed * giga;
+  counters[5].cumulative = 1;
+  /* the compactions' writes over the ingest, i.e. the write amplification
+   * since open without the WAL, poor for small volumes since the stats are
+   * rounded. The flushes are the level-0 writes of the compaction stats,
+   * so these are already counted by the cumulative compaction. */
+  counters[6].name = "w-amp";
+  counters[6].value = (ingest > 0) ? compacted / ingest : NAN;
+  counters[6].cumulative = 0;
+  /* the raw keys and values per bytes of the data blocks of all the SST
+   * files, i.e. the compression achieved without the memtables */
+  counters[7].name = "compression";
+  counters[7].value = (stored > 0) ? raw / stored : NAN;
+  counters[7].cumulative = 0;
+
+  free(l0);
+  free(db);
+  free(cf);
+  free(sst);
+  return 8;
+}
+
 iadriver ia_rocksdb = {.name = "rocksdb",
                        .priv = NULL,
                        .open = ia_rocksdb_open,
                        .close = ia_rocksdb_close,
+                       .option = ia_rocksdb_option,
+                       .counters = ia_rocksdb_counters,
+                       .merge = ia_rocksdb_merge,
 
                        .thread_new = ia_rocksdb_thread_new,
                        .thread_dispose = ia_rocksdb_thread_dispose,
                        .begin = ia_rocksdb_begin,
                        .next = ia_rocksdb_next,
+                       .seek = ia_rocksdb_seek,
                        .done = ia_rocksdb_done};
@@ -131,12 +131,17 @@ static int ia_sophia_begin(iacontext *ctx, iabenchmark step) {
   int rc = 0;
 
   switch (step) {
-  case IA_SET:
-  case IA_DELETE:
   case IA_GET:
     ctx->txn = self->db;
     break;
 
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2) {
+      ctx->txn = self->db;
+      break;
+    }
+    /* fallthrough */
   case IA_BATCH:
   case IA_CRUD:
     ctx->txn = sp_begin(self->env);
@@ -172,12 +177,17 @@ static int ia_sophia_done(iacontext *ctx, iabenchmark step) {
   int rc = 0;
 
   switch (step) {
-  case IA_SET:
-  case IA_DELETE:
   case IA_GET:
     ctx->txn = NULL;
     break;
 
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2) {
+      ctx->txn = NULL;
+      break;
+    }
+    /* fallthrough */
   case IA_BATCH:
   case IA_CRUD:
     if (ctx->txn)
@@ -308,10 +318,51 @@ error_done:
   return -1;
 }
 
+static double ia_sophia_stat(iaprivate *self, const char *name) {
+  const int64_t value = sp_getint(self->env, name);
+  return (value < 0) ? NAN : (double)value;
+}
+
+static int ia_sophia_counters(iacounter *counters, int limit) {
+  iaprivate *self = ioarena.driver->priv;
+  if (!self || !self->env || limit < 5)
+    return 0;
+
+  counters[0].name = "nodes";
+  counters[0].value = ia_sophia_stat(self, "db.test.index.node_count");
+  counters[0].cumulative = 0;
+  counters[1].name = "branch_max";
+  counters[1].value = ia_sophia_stat(self, "db.test.index.branch_max");
+  counters[1].cumulative = 0;
+  counters[2].name = "memory";
+  counters[2].value = ia_sophia_stat(self, "db.test.index.memory_used");
+  counters[2].cumulative = 0;
+  counters[3].name = "size";
+  counters[3].value = ia_sophia_stat(self, "db.test.index.size");
+  counters[3].cumulative = 0;
+  counters[4].name = "read_disk";
+  counters[4].value = ia_sophia_stat(self, "db.test.index.read_disk");
+  counters[4].cumulative = 1;
+  return 5;
+}
+
+static const char *ia_sophia_version(void) {
+  static char version[32];
+  iaprivate *self = ioarena.driver->priv;
+  char *str = sp_getstring(self->env, "sophia.version", NULL);
+  if (!str)
+    return NULL;
+  snprintf(version, sizeof(version), "%s", str);
+  free(str);
+  return version;
+}
+
 iadriver ia_sophia = {.name = "sophia",
                       .priv = NULL,
                       .open = ia_sophia_open,
                       .close = ia_sophia_close,
+                      .version = ia_sophia_version,
+                      .counters = ia_sophia_counters,
 
                       .thread_new = ia_sophia_thread_new,
                       .thread_dispose = ia_sophia_thread_dispose,
@@ -10,36 +10,21 @@
 
 struct iaprivate {
   sqlite3 *db;
+  char *path;
 };
+/* each doer has a connection of its own, since sqlite serializes the threads
+ * which share a connection, so these never get busy but share a transaction */
 struct iacontext {
-  void *value;
+  sqlite3 *db;
 };
 #define CMD_SIZE 1024
 
-static int ia_sqlite3_open(const char *datadir) {
+/* the synchronous and the journal_mode are per connection */
+static int ia_sqlite3_pragmas(sqlite3 *db, char **zErrMsg) {
   int rc;
-  char *zErrMsg = 0;
   char cmd_buf[CMD_SIZE];
-  const char *db_name = "/test.sqlite";
-  int db_path_sz = strlen(datadir) + strlen(db_name) + 1;
-  char db_path[db_path_sz];
-  iadriver *drv = ioarena.driver;
-  drv->priv = malloc(sizeof(iaprivate));
-  if (drv->priv == NULL)
-    return -1;
-
-  iaprivate *self = drv->priv;
-
-  memset(db_path, 0, db_path_sz);
-  strcat(db_path, datadir);
-  strcat(db_path, db_name);
-
-  rc = sqlite3_open(db_path, &(self->db));
-  if (rc) {
-    fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(self->db));
-    sqlite3_close(self->db);
-    goto bailout;
-  }
+  /* the doers' connections are set up concurrently, so do wait here */
+  sqlite3_busy_timeout(db, 10000);
   /* LY: suggestions are welcome */
   memset(cmd_buf, 0, CMD_SIZE);
 
@@ -60,11 +45,10 @@ static int ia_sqlite3_open(const char *datadir) {
            ia_syncmode2str(ioarena.conf.syncmode));
     return -1;
   }
-  rc = sqlite3_exec(self->db, cmd_buf, 0, 0, &zErrMsg);
+  rc = sqlite3_exec(db, cmd_buf, 0, 0, zErrMsg);
   if (rc != SQLITE_OK) {
-    fprintf(stderr, "SQL error: %s\n", zErrMsg);
-    sqlite3_close(self->db);
-    goto bailout;
+    fprintf(stderr, "SQL error: %s\n", *zErrMsg);
+    return -1;
   }
 
   memset(cmd_buf, 0, CMD_SIZE);
@@ -85,10 +69,44 @@ static int ia_sqlite3_open(const char *datadir) {
     return -1;
   }
 
-  rc = sqlite3_exec(self->db, cmd_buf, 0, 0, &zErrMsg);
+  rc = sqlite3_exec(db, cmd_buf, 0, 0, zErrMsg);
   if (rc != SQLITE_OK) {
-    fprintf(stderr, "SQL error: %s\n", zErrMsg);
+    fprintf(stderr, "SQL error: %s\n", *zErrMsg);
+    return -1;
+  }
+
+  /* the conflicts are not waited for here, but by the benchmark's backoff,
+   * see ia_sqlite3_busy() */
+  sqlite3_busy_timeout(db, 0);
+  return 0;
+}
+
+static int ia_sqlite3_open(const char *datadir) {
+  int rc;
+  char *zErrMsg = 0;
+  const char *db_name = "/test.sqlite";
+  iadriver *drv = ioarena.driver;
+  drv->priv = calloc(1, sizeof(iaprivate));
+  if (drv->priv == NULL)
+    return -1;
+
+  iaprivate *self = drv->priv;
+  self->path = malloc(strlen(datadir) + strlen(db_name) + 1);
+  if (self->path == NULL)
+    return -1;
+  strcpy(self->path, datadir);
+  strcat(self->path, db_name);
+
+  rc = sqlite3_open(self->path, &(self->db));
+  if (rc) {
+    fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(self->db));
     sqlite3_close(self->db);
+    self->db = NULL;
+    goto bailout;
+  }
+  if (ia_sqlite3_pragmas(self->db, &zErrMsg)) {
+    sqlite3_close(self->db);
+    self->db = NULL;
     goto bailout;
   }
 
@@ -101,6 +119,7 @@ static int ia_sqlite3_open(const char *datadir) {
   if (rc != SQLITE_OK) {
     fprintf(stderr, "SQL error: %s\n", zErrMsg);
     sqlite3_close(self->db);
+    self->db = NULL;
     goto bailout;
   }
 
@@ -127,37 +146,75 @@ static int ia_sqlite3_close(void) {
     ioarena.driver->priv = NULL;
     if (self->db)
       sqlite3_close(self->db);
+    free(self->path);
     free(self);
   }
   return 0;
 }
 
-static void ia_sqlite3_thread_dispose(iacontext *ctx) { free(ctx); }
+static void ia_sqlite3_thread_dispose(iacontext *ctx) {
+  if (ctx->db)
+    sqlite3_close(ctx->db);
+  free(ctx);
+}
 
 static iacontext *ia_sqlite3_thread_new(void) {
+  iaprivate *self = ioarena.driver->priv;
+  char *zErrMsg = 0;
   iacontext *ctx = calloc(1, sizeof(iacontext));
+  if (!ctx)
+    return NULL;
+
+  if (sqlite3_open(self->path, &ctx->db) != SQLITE_OK) {
+    ia_log("error: %s, %s", __func__, sqlite3_errmsg(ctx->db));
+    goto bailout;
+  }
+  if (ia_sqlite3_pragmas(ctx->db, &zErrMsg)) {
+    ia_log("error: %s, %s", __func__, zErrMsg);
+    sqlite3_free(zErrMsg);
+    goto bailout;
+  }
   return ctx;
+
+bailout:
+  ia_sqlite3_thread_dispose(ctx);
+  return NULL;
+}
+
+static int ia_sqlite3_conflict(int rc) {
+  return rc == SQLITE_BUSY || rc == SQLITE_LOCKED;
+}
+
+/* a busy database rolls the doer's transaction back, if any, then the
+ * benchmark retries it, see ia_backoff() */
+static int ia_sqlite3_busy(iacontext *ctx, char *zErrMsg) {
+  sqlite3_free(zErrMsg);
+  if (!sqlite3_get_autocommit(ctx->db))
+    (void)sqlite3_exec(ctx->db, "ROLLBACK;", 0, 0, NULL);
+  return EBUSY;
 }
 
 static int ia_sqlite3_begin(iacontext *ctx, iabenchmark step) {
   int rc;
-  (void)ctx;
   char *zErrMsg = 0;
-  iaprivate *self = ioarena.driver->priv;
 
   switch (step) {
+  case IA_SET:
+  case IA_DELETE:
+    rc = 0;
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_CRUD:
   case IA_BATCH:
-    rc = sqlite3_exec(self->db, "BEGIN;", 0, 0, &zErrMsg);
+    rc = sqlite3_exec(ctx->db, "BEGIN;", 0, 0, &zErrMsg);
+    if (ia_sqlite3_conflict(rc))
+      return ia_sqlite3_busy(ctx, zErrMsg);
     if (rc != SQLITE_OK) {
       fprintf(stderr, "SQL error: %s\n", zErrMsg);
       goto bailout;
     }
     break;
-  case IA_SET:
-  case IA_DELETE:
-    rc = 0;
-    break;
 
   case IA_ITERATE:
   case IA_GET:
@@ -178,21 +235,25 @@ bailout:
 
 static int ia_sqlite3_done(iacontext *ctx, iabenchmark step) {
   int rc;
-  (void)ctx;
   char *zErrMsg = 0;
-  iaprivate *self = ioarena.driver->priv;
 
   switch (step) {
+  case IA_SET:
+  case IA_DELETE:
+    rc = 0;
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_CRUD:
   case IA_BATCH:
-    rc = sqlite3_exec(self->db, "COMMIT;", 0, 0, &zErrMsg);
+    rc = sqlite3_exec(ctx->db, "COMMIT;", 0, 0, &zErrMsg);
+    if (ia_sqlite3_conflict(rc))
+      return ia_sqlite3_busy(ctx, zErrMsg);
     if (rc != SQLITE_OK) {
       fprintf(stderr, "SQL error: %s\n", zErrMsg);
       goto bailout;
     }
     break;
-  case IA_SET:
-  case IA_DELETE:
   case IA_ITERATE:
   case IA_GET:
     rc = 0;
@@ -230,24 +291,23 @@ static int select_callback(void *data, int argc, char **argv,
 
 static int ia_sqlite3_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   int rc;
-  (void)ctx;
   char cmd_buf[CMD_SIZE];
   char *zErrMsg = 0;
 
-  iaprivate *self = ioarena.driver->priv;
-
   switch (step) {
   case IA_SET:
     memset(cmd_buf, 0, CMD_SIZE);
+    /* an upsert, since the repeats and the sweep points (as well as the
+     * update benchmark) write the same keys again */
     snprintf(cmd_buf, CMD_SIZE,
-             "INSERT INTO benchmark_t (key, value) VALUES(\"%s\", ?);", kv->k);
-    // snprintf(cmd_buf, CMD_SIZE, "REPLACE INTO benchmark_t (key, value)
-    // VALUES(\"%s\", ?);", kv->k);
+             "INSERT OR REPLACE INTO benchmark_t (key, value) "
+             "VALUES(\"%s\", ?);",
+             kv->k);
     sqlite3_stmt *stmt = NULL;
-    rc = sqlite3_prepare_v2(self->db, cmd_buf, -1, &stmt, NULL);
+    rc = sqlite3_prepare_v2(ctx->db, cmd_buf, -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
       fprintf(stderr, "prepare failed: %s, error: %s\n",
-              sqlite3_errmsg(self->db), zErrMsg);
+              sqlite3_errmsg(ctx->db), zErrMsg);
       // rc = -1;
       goto bailout;
     } else {
@@ -255,13 +315,17 @@ static int ia_sqlite3_next(iacontext *ctx, iabenchmark step, iakv *kv) {
       // before the buffer is freed:
       rc = sqlite3_bind_blob(stmt, 1, kv->v, kv->vsize, SQLITE_STATIC);
       if (rc != SQLITE_OK) {
-        fprintf(stderr, "bind failed, error: %s\n", sqlite3_errmsg(self->db));
+        fprintf(stderr, "bind failed, error: %s\n", sqlite3_errmsg(ctx->db));
         goto bailout;
       } else {
         rc = sqlite3_step(stmt);
+        if (ia_sqlite3_conflict(rc)) {
+          sqlite3_finalize(stmt);
+          return ia_sqlite3_busy(ctx, zErrMsg);
+        }
         if (rc != SQLITE_DONE) {
           fprintf(stderr, "execution failed, error: %s\n",
-                  sqlite3_errmsg(self->db));
+                  sqlite3_errmsg(ctx->db));
           goto bailout;
         }
       }
@@ -273,10 +337,11 @@ static int ia_sqlite3_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     memset(cmd_buf, 0, CMD_SIZE);
     snprintf(cmd_buf, CMD_SIZE, "DELETE FROM benchmark_t WHERE key = \"%s\";",
              kv->k);
-    rc = sqlite3_exec(self->db, cmd_buf, 0, 0, &zErrMsg);
+    rc = sqlite3_exec(ctx->db, cmd_buf, 0, 0, &zErrMsg);
+    if (ia_sqlite3_conflict(rc))
+      return ia_sqlite3_busy(ctx, zErrMsg);
     if (rc != SQLITE_OK) {
       fprintf(stderr, "SQL error: %s\n", zErrMsg);
-      sqlite3_close(self->db);
       goto bailout;
     }
     rc = 0;
@@ -285,10 +350,11 @@ static int ia_sqlite3_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     memset(cmd_buf, 0, CMD_SIZE);
     snprintf(cmd_buf, CMD_SIZE, "SELECT * FROM benchmark_t WHERE key = \"%s\";",
              kv->k);
-    rc = sqlite3_exec(self->db, cmd_buf, select_callback, NULL, &zErrMsg);
+    rc = sqlite3_exec(ctx->db, cmd_buf, select_callback, NULL, &zErrMsg);
+    if (ia_sqlite3_conflict(rc))
+      return ia_sqlite3_busy(ctx, zErrMsg);
     if (rc != SQLITE_OK) {
       fprintf(stderr, "SQL error: %s\n", zErrMsg);
-      sqlite3_close(self->db);
       goto bailout;
     }
     rc = 0;
@@ -308,10 +374,13 @@ bailout:
   return -1;
 }
 
+static const char *ia_sqlite3_version(void) { return sqlite3_libversion(); }
+
 iadriver ia_sqlite3 = {.name = "sqlite3",
                        .priv = NULL,
                        .open = ia_sqlite3_open,
                        .close = ia_sqlite3_close,
+                       .version = ia_sqlite3_version,
 
                        .thread_new = ia_sqlite3_thread_new,
                        .thread_dispose = ia_sqlite3_thread_dispose,
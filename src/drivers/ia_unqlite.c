@@ -14,21 +14,73 @@ struct iaprivate {
 
 struct iacontext {
   unqlite_kv_cursor *cursor;
+  char *key /* the copy of the current key of the iteration */;
+  size_t key_len, key_room;
 };
 
+static struct {
+  intmax_t page_size, cache_pages;
+  int8_t in_memory;
+} globals;
+
+static int ia_unqlite_option(iacontext *ctx, const char *arg) {
+  if (ctx)
+    return 0 /* no any non-global options */;
+
+  if (strcmp(arg, "--help") == 0) {
+    ia_log("  -o %s=<bytes> (default: 4K)", "PAGE_SIZE");
+    ia_log("  -o %s=<pages> (default: engine's)", "CACHE");
+    ia_log("  -o %s=<ON|OFF> (default: OFF)", "IN_MEMORY");
+    ia_log("     PAGE_SIZE is a power of two in 512..64K, CACHE is the limit "
+           "of the page cache");
+    return 0;
+  }
+
+  int done = 0;
+  while (*arg && !done) {
+    const char *const prev = arg;
+    done = ia_parse_option_size(&arg, "PAGE_SIZE", &globals.page_size);
+    if (!done)
+      done = ia_parse_option_size(&arg, "CACHE", &globals.cache_pages);
+    if (!done)
+      done = ia_parse_option_bool(&arg, "IN_MEMORY", &globals.in_memory);
+    if (!done && arg == prev)
+      break /* unknown option */;
+  }
+
+  if (done == 1)
+    return 0;
+  ia_log("%s: invalid option or value `%s`", "unqlite", arg);
+  return done ? done : -1;
+}
+
 static int ia_unqlite_open(const char *datadir) {
   iadriver *drv = ioarena.driver;
-  drv->priv = malloc(sizeof(iaprivate));
+  drv->priv = calloc(1, sizeof(iaprivate));
   if (drv->priv == NULL)
     return -1;
 
   iaprivate *self = drv->priv;
+  int st;
+
+  /* the library-wide page size could be set only before the library is
+   * initialized, i.e. before the first open, see ia_unqlite_close() */
+  const int page_size =
+      (globals.page_size < INT_MAX) ? (int)globals.page_size : INT_MAX;
+  if (page_size && unqlite_lib_config(UNQLITE_LIB_CONFIG_PAGE_SIZE,
+                                      page_size) != UNQLITE_OK) {
+    ia_log("error: %s(), unsupported page size %jd", __func__,
+           globals.page_size);
+    return -1;
+  }
 
   char *filename = NULL;
   if (asprintf(&filename, "%s/test.db", datadir) < 0)
     return -1;
 
   uint32_t flags = UNQLITE_OPEN_CREATE;
+  if (globals.in_memory == ia_opt_bool_on)
+    flags |= UNQLITE_OPEN_IN_MEMORY;
 
   switch (ioarena.conf.walmode) {
   case IA_WAL_INDEF:
@@ -45,19 +97,33 @@ static int ia_unqlite_open(const char *datadir) {
     return -1;
   }
 
-  int st = unqlite_open(&self->db, filename, flags);
+  st = unqlite_open(&self->db, filename, flags);
   free(filename);
   if (st != UNQLITE_OK)
-    return -1;
+    goto bailout;
 
+  if (globals.cache_pages) {
+    const int pages =
+        (globals.cache_pages < INT_MAX) ? (int)globals.cache_pages : INT_MAX;
+    st = unqlite_config(self->db, UNQLITE_CONFIG_MAX_PAGE_CACHE, pages);
+    if (st != UNQLITE_OK)
+      goto bailout;
+  }
   return 0;
+
+bailout:
+  ia_log("error: %s, %d", __func__, st);
+  return -1;
 }
 
 static int ia_unqlite_close(void) {
   iaprivate *self = ioarena.driver->priv;
   if (self) {
-    unqlite_close(self->db);
+    ioarena.driver->priv = NULL;
+    if (self->db)
+      unqlite_close(self->db);
     free(self);
+    unqlite_lib_shutdown();
   }
   return 0;
 }
@@ -66,9 +132,34 @@ static void ia_unqlite_thread_dispose(iacontext *ctx) {
   iaprivate *self = ioarena.driver->priv;
   if (ctx->cursor)
     unqlite_kv_cursor_release(self->db, ctx->cursor);
+  free(ctx->key);
   free(ctx);
 }
 
+/* the engine hands out a value in-place, by chunks for the overflow
+ * pages, so it is consumed without copying, just the length is counted */
+static int ia_unqlite_consume(const void *data, unsigned int len, void *arg) {
+  (void)data;
+  *(size_t *)arg += len;
+  return UNQLITE_OK;
+}
+
+/* the key is kept in the context, it is valid until the following next */
+static int ia_unqlite_keep(const void *data, unsigned int len, void *arg) {
+  iacontext *ctx = arg;
+  if (ctx->key_len + len > ctx->key_room) {
+    const size_t room = (ctx->key_len + len) * 2;
+    char *key = realloc(ctx->key, room);
+    if (!key)
+      return UNQLITE_ABORT;
+    ctx->key = key;
+    ctx->key_room = room;
+  }
+  memcpy(ctx->key + ctx->key_len, data, len);
+  ctx->key_len += len;
+  return UNQLITE_OK;
+}
+
 static iacontext *ia_unqlite_thread_new(void) {
   iacontext *ctx = calloc(1, sizeof(iacontext));
   return ctx;
@@ -80,16 +171,21 @@ static int ia_unqlite_begin(iacontext *ctx, iabenchmark step) {
 
   switch (step) {
   case IA_GET:
-  case IA_SET:
-  case IA_DELETE:
     break;
 
   case IA_ITERATE:
     st = unqlite_kv_cursor_init(self->db, &ctx->cursor);
     if (st != UNQLITE_OK)
       goto bailout;
+    /* an empty database is not an error, see the valid_entry in next */
+    unqlite_kv_cursor_first_entry(ctx->cursor);
     break;
 
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_BATCH:
   case IA_CRUD:
     st = unqlite_begin(self->db);
@@ -115,8 +211,6 @@ static int ia_unqlite_done(iacontext *ctx, iabenchmark step) {
 
   switch (step) {
   case IA_GET:
-  case IA_SET:
-  case IA_DELETE:
     break;
 
   case IA_ITERATE:
@@ -126,6 +220,11 @@ static int ia_unqlite_done(iacontext *ctx, iabenchmark step) {
     }
     break;
 
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_CRUD:
   case IA_BATCH:
     st = unqlite_commit(self->db);
@@ -147,8 +246,6 @@ bailout:
 
 static int ia_unqlite_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   iaprivate *self = ioarena.driver->priv;
-  char buffer[256];
-  unqlite_int64 size = sizeof(buffer);
   int st;
 
   switch (step) {
@@ -168,7 +265,9 @@ static int ia_unqlite_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     break;
 
   case IA_GET:
-    st = unqlite_kv_fetch(self->db, kv->k, kv->ksize, buffer, &size);
+    kv->vsize = 0;
+    st = unqlite_kv_fetch_callback(self->db, kv->k, kv->ksize,
+                                   ia_unqlite_consume, &kv->vsize);
     if (st != UNQLITE_OK) {
       if (st == UNQLITE_NOTFOUND)
         return ENOENT;
@@ -177,23 +276,24 @@ static int ia_unqlite_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     break;
 
   case IA_ITERATE:
-    st = unqlite_kv_cursor_next_entry(ctx->cursor);
-    if (st != UNQLITE_OK) {
-      if (st == UNQLITE_NOTFOUND || st == UNQLITE_EOF)
-        return ENOENT;
-      goto bailout;
-    }
+    if (!unqlite_kv_cursor_valid_entry(ctx->cursor))
+      return ENOENT;
 
-    int key_size = kv->ksize;
-    st = unqlite_kv_cursor_key(ctx->cursor, kv->k, &key_size);
-    if (st != UNQLITE_OK) {
+    ctx->key_len = 0;
+    st = unqlite_kv_cursor_key_callback(ctx->cursor, ia_unqlite_keep, ctx);
+    if (st != UNQLITE_OK)
       goto bailout;
-    }
+    kv->k = ctx->key;
+    kv->ksize = ctx->key_len;
 
-    st = unqlite_kv_cursor_data(ctx->cursor, buffer, &size);
-    if (st != UNQLITE_OK) {
+    kv->vsize = 0;
+    st = unqlite_kv_cursor_data_callback(ctx->cursor, ia_unqlite_consume,
+                                         &kv->vsize);
+    if (st != UNQLITE_OK)
       goto bailout;
-    }
+
+    /* the end is detected by the valid_entry on the following next */
+    unqlite_kv_cursor_next_entry(ctx->cursor);
     break;
 
   default:
@@ -208,10 +308,14 @@ bailout:
   return -1;
 }
 
+static const char *ia_unqlite_version(void) { return unqlite_lib_version(); }
+
 iadriver ia_unqlite = {.name = "unqlite",
                        .priv = NULL,
                        .open = ia_unqlite_open,
                        .close = ia_unqlite_close,
+                       .option = ia_unqlite_option,
+                       .version = ia_unqlite_version,
 
                        .thread_new = ia_unqlite_thread_new,
                        .thread_dispose = ia_unqlite_thread_dispose,
@@ -103,8 +103,6 @@ static int ia_upscaledb_begin(iacontext *ctx, iabenchmark step) {
 
   switch (step) {
   case IA_GET:
-  case IA_SET:
-  case IA_DELETE:
     break;
 
   case IA_ITERATE:
@@ -113,6 +111,11 @@ static int ia_upscaledb_begin(iacontext *ctx, iabenchmark step) {
       goto bailout;
     break;
 
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_BATCH:
   case IA_CRUD:
     st = ups_txn_begin(&ctx->txn, self->env, NULL, NULL, 0);
@@ -137,8 +140,6 @@ static int ia_upscaledb_done(iacontext *ctx, iabenchmark step) {
 
   switch (step) {
   case IA_GET:
-  case IA_SET:
-  case IA_DELETE:
     break;
 
   case IA_ITERATE:
@@ -148,6 +149,8 @@ static int ia_upscaledb_done(iacontext *ctx, iabenchmark step) {
     }
     break;
 
+  case IA_SET:
+  case IA_DELETE:
   case IA_CRUD:
   case IA_BATCH:
     if (ctx->txn) {
@@ -234,10 +237,19 @@ bailout:
   return -1;
 }
 
+static const char *ia_upscaledb_version(void) {
+  static char version[32];
+  uint32_t major, minor, revision;
+  ups_get_version(&major, &minor, &revision);
+  snprintf(version, sizeof(version), "%u.%u.%u", major, minor, revision);
+  return version;
+}
+
 iadriver ia_upscaledb = {.name = "upscaledb",
                          .priv = NULL,
                          .open = ia_upscaledb_open,
                          .close = ia_upscaledb_close,
+                         .version = ia_upscaledb_version,
 
                          .thread_new = ia_upscaledb_thread_new,
                          .thread_dispose = ia_upscaledb_thread_dispose,
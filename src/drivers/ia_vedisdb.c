@@ -124,13 +124,17 @@ static int ia_vedisdb_begin(iacontext *ctx, iabenchmark step) {
   iaprivate *self = ioarena.driver->priv;
 
   switch (step) {
+  case IA_SET:
+  case IA_DELETE:
+    rc = 0;
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_BATCH:
   case IA_CRUD:
     rc = vedis_begin(self->db);
     rc = (rc == VEDIS_OK ? 0 : -1);
     break;
-  case IA_SET:
-  case IA_DELETE:
   case IA_ITERATE:
   case IA_GET:
     rc = 0;
@@ -151,6 +155,12 @@ static int ia_vedisdb_done(iacontext *ctx, iabenchmark step) {
   iaprivate *self = ioarena.driver->priv;
 
   switch (step) {
+  case IA_SET:
+  case IA_DELETE:
+    rc = 0;
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_BATCH:
   case IA_CRUD:
     rc = vedis_commit(self->db);
@@ -165,8 +175,6 @@ static int ia_vedisdb_done(iacontext *ctx, iabenchmark step) {
       rc = -1;
     }
     break;
-  case IA_SET:
-  case IA_DELETE:
   case IA_ITERATE:
   case IA_GET:
     rc = 0;
@@ -254,10 +262,13 @@ static int ia_vedisdb_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   return rc;
 }
 
+static const char *ia_vedisdb_version(void) { return vedis_lib_version(); }
+
 iadriver ia_vedisdb = {.name = "vedisdb",
                        .priv = NULL,
                        .open = ia_vedisdb_open,
                        .close = ia_vedisdb_close,
+                       .version = ia_vedisdb_version,
 
                        .thread_new = ia_vedisdb_thread_new,
                        .thread_dispose = ia_vedisdb_thread_dispose,
@@ -16,14 +16,228 @@ struct iaprivate {
   const char *transaction_config;
   const char *table_name;
   char need_checkpoints;
+  /* the checkpointer, running in the background when need_checkpoints */
+  pthread_t checkpointer;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int stop;
+  uintmax_t checkpoints, checkpoints_ns;
 };
 
 struct iacontext {
   WT_SESSION *session;
   WT_CURSOR *cursor;
   int transaction;
+  int seeked /* the cursor is at the record for the next */;
 };
 
+#define UNSET -1
+/* the pause between the forced checkpoints */
+#define CHECKPOINT_PAUSE_MS 100
+
+static const char *const table_types[] = {"lsm", "btree", NULL};
+static const char *const log_compressors[] = {"none", "snappy", "lz4", "zlib",
+                                              "zstd", NULL};
+
+struct wt_opts {
+  int8_t prefix_compression;
+  int table_type;
+  int log_compressor;
+  intmax_t cache_size;
+  intmax_t eviction_threads_min, eviction_threads_max;
+  intmax_t eviction_target, eviction_trigger;
+  intmax_t eviction_dirty_target, eviction_dirty_trigger;
+  intmax_t checkpoint_wait;
+  intmax_t leaf_page, internal_page;
+};
+
+static struct wt_opts globals = {.table_type = UNSET,
+                                 .log_compressor = UNSET,
+                                 .cache_size = UNSET,
+                                 .eviction_threads_min = UNSET,
+                                 .eviction_threads_max = UNSET,
+                                 .eviction_target = UNSET,
+                                 .eviction_trigger = UNSET,
+                                 .eviction_dirty_target = UNSET,
+                                 .eviction_dirty_trigger = UNSET,
+                                 .checkpoint_wait = UNSET,
+                                 .leaf_page = UNSET,
+                                 .internal_page = UNSET};
+
+static int ia_wt_option(iacontext *ctx, const char *arg) {
+  if (ctx)
+    return 0 /* no any non-global options */;
+
+  if (strcmp(arg, "--help") == 0) {
+    ia_log("  -o %s=<bytes> (default: 1G)", "CACHE");
+    ia_log("  -o %s=<number>", "EVICTION_THREADS_MIN");
+    ia_log("  -o %s=<number>", "EVICTION_THREADS_MAX");
+    ia_log("  -o %s=<percent>", "EVICTION_TARGET");
+    ia_log("  -o %s=<percent>", "EVICTION_TRIGGER");
+    ia_log("  -o %s=<percent>", "EVICTION_DIRTY_TARGET");
+    ia_log("  -o %s=<percent>", "EVICTION_DIRTY_TRIGGER");
+    ia_log("  -o %s=<seconds> (default: 0, i.e. none)", "CHECKPOINT_WAIT");
+    ia_log("  -o %s=<codec> (default: none)", "LOG_COMPRESSION");
+    ia_log("     choices: none, snappy, lz4, zlib, zstd");
+    ia_log("  -o %s=<bytes> (default: 4K)", "LEAF_PAGE");
+    ia_log("  -o %s=<bytes> (default: 4K)", "INTERNAL_PAGE");
+    ia_log("  -o %s=<ON|OFF> (default: OFF)", "PREFIX_COMPRESSION");
+    ia_log("  -o %s=<type> (default: lsm)", "TYPE");
+    ia_log("     choices: lsm, btree");
+    ia_log("     sizes could be given with K, M, G or T suffix");
+    return 0;
+  }
+
+  int done = 0;
+  while (*arg && !done) {
+    const char *const prev = arg;
+    done = ia_parse_option_bool(&arg, "PREFIX_COMPRESSION",
+                                &globals.prefix_compression);
+    if (!done)
+      done = ia_parse_option_enum(&arg, "TYPE", table_types,
+                                  &globals.table_type);
+    if (!done)
+      done = ia_parse_option_enum(&arg, "LOG_COMPRESSION", log_compressors,
+                                  &globals.log_compressor);
+    if (!done)
+      done = ia_parse_option_size(&arg, "CACHE", &globals.cache_size);
+    if (!done)
+      done = ia_parse_option_size(&arg, "EVICTION_THREADS_MIN",
+                                  &globals.eviction_threads_min);
+    if (!done)
+      done = ia_parse_option_size(&arg, "EVICTION_THREADS_MAX",
+                                  &globals.eviction_threads_max);
+    if (!done)
+      done = ia_parse_option_size(&arg, "EVICTION_TARGET",
+                                  &globals.eviction_target);
+    if (!done)
+      done = ia_parse_option_size(&arg, "EVICTION_TRIGGER",
+                                  &globals.eviction_trigger);
+    if (!done)
+      done = ia_parse_option_size(&arg, "EVICTION_DIRTY_TARGET",
+                                  &globals.eviction_dirty_target);
+    if (!done)
+      done = ia_parse_option_size(&arg, "EVICTION_DIRTY_TRIGGER",
+                                  &globals.eviction_dirty_trigger);
+    if (!done)
+      done = ia_parse_option_size(&arg, "CHECKPOINT_WAIT",
+                                  &globals.checkpoint_wait);
+    if (!done)
+      done = ia_parse_option_size(&arg, "LEAF_PAGE", &globals.leaf_page);
+    if (!done)
+      done =
+          ia_parse_option_size(&arg, "INTERNAL_PAGE", &globals.internal_page);
+    if (!done && arg == prev)
+      break /* unknown option */;
+  }
+
+  if (done == 1)
+    return 0;
+  ia_log("%s: invalid option or value `%s`", "wiredtiger", arg);
+  return done ? done : -1;
+}
+
+static intmax_t peek_option(intmax_t value, intmax_t dflt) {
+  return (value != UNSET) ? value : dflt;
+}
+
+/* checkpoints are required for durability when there is no WAL,
+ * but doing them inline would charge a single op with the whole cost,
+ * so these are done back-to-back in the background and show up as an
+ * interference instead. */
+static void *ia_wt_checkpointer(void *arg) {
+  iaprivate *self = arg;
+  WT_SESSION *session = NULL;
+  int rc = self->conn->open_session(self->conn, NULL, NULL, &session);
+  if (rc != 0)
+    goto bailout;
+
+  pthread_mutex_lock(&self->mutex);
+  while (!self->stop) {
+    pthread_mutex_unlock(&self->mutex);
+    const ia_timestamp_t t0 = ia_timestamp_ns();
+    rc = session->checkpoint(session, NULL);
+    const ia_timestamp_t t1 = ia_timestamp_ns();
+    pthread_mutex_lock(&self->mutex);
+    if (rc != 0) {
+      pthread_mutex_unlock(&self->mutex);
+      goto bailout;
+    }
+    self->checkpoints += 1;
+    self->checkpoints_ns += t1 - t0;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += CHECKPOINT_PAUSE_MS * 1000000l;
+    if (deadline.tv_nsec >= 1000000000l) {
+      deadline.tv_sec += 1;
+      deadline.tv_nsec -= 1000000000l;
+    }
+    if (!self->stop)
+      pthread_cond_timedwait(&self->cond, &self->mutex, &deadline);
+  }
+  pthread_mutex_unlock(&self->mutex);
+  session->close(session, NULL);
+  return NULL;
+
+bailout:
+  ia_log("error: %s, %s (%d)", __func__, wiredtiger_strerror(rc), rc);
+  if (session)
+    session->close(session, NULL);
+  return NULL;
+}
+
+static int64_t ia_wt_stat(WT_CURSOR *stats, int key) {
+  const char *desc, *pvalue;
+  int64_t value;
+  stats->set_key(stats, key);
+  if (stats->search(stats) != 0 ||
+      stats->get_value(stats, &desc, &pvalue, &value) != 0)
+    return -1;
+  return value;
+}
+
+/* the bytes of the pages written from the cache per the ones written by the
+ * block-manager, i.e. the compression achieved since open */
+static double ia_wt_compression(iaprivate *self) {
+  WT_SESSION *session = NULL;
+  WT_CURSOR *stats = NULL;
+  double ratio = NAN;
+  if (self->conn->open_session(self->conn, NULL, NULL, &session) != 0)
+    return NAN;
+  if (session->open_cursor(session, "statistics:", NULL, NULL, &stats) == 0) {
+    const int64_t raw = ia_wt_stat(stats, WT_STAT_CONN_CACHE_BYTES_WRITE);
+    const int64_t stored = ia_wt_stat(stats, WT_STAT_CONN_BLOCK_BYTE_WRITE);
+    if (raw >= 0 && stored > 0)
+      ratio = raw / (double)stored;
+    stats->close(stats);
+  }
+  session->close(session, NULL);
+  return ratio;
+}
+
+static int ia_wt_counters(iacounter *counters, int limit) {
+  iaprivate *self = ioarena.driver->priv;
+  if (!self || !self->conn || limit < 3)
+    return 0;
+
+  counters[0].name = "compression";
+  counters[0].value = ia_wt_compression(self);
+  counters[0].cumulative = 0;
+  if (!self->need_checkpoints)
+    return 1;
+
+  pthread_mutex_lock(&self->mutex);
+  counters[1].name = "ckpt";
+  counters[1].value = self->checkpoints;
+  counters[1].cumulative = 1;
+  counters[2].name = "ckpt_ms";
+  counters[2].value = self->checkpoints_ns / 1e6;
+  counters[2].cumulative = 1;
+  pthread_mutex_unlock(&self->mutex);
+  return 3;
+}
+
 static int ia_wt_open(const char *datadir) {
   iadriver *drv = ioarena.driver;
   drv->priv = calloc(1, sizeof(iaprivate));
@@ -59,10 +273,10 @@ static int ia_wt_open(const char *datadir) {
     wal_config = "";
     break;
   case IA_WAL_ON:
-    wal_config = "log=(enabled=true),";
+    wal_config = "enabled=true";
     break;
   case IA_WAL_OFF:
-    wal_config = "log=(enabled=false),";
+    wal_config = "enabled=false";
     break;
   default:
     ia_log("error: %s(): unsupported walmode %s", __func__,
@@ -73,9 +287,48 @@ static int ia_wt_open(const char *datadir) {
   if (ioarena.conf.syncmode == IA_SYNC && ioarena.conf.walmode != IA_WAL_ON)
     self->need_checkpoints = 1;
 
-  char config[256];
-  snprintf(config, sizeof(config), "create,cache_size=1Gb,%s%s", wal_config,
-           durability_config);
+  char config[1024], *s = config, *const end = config + sizeof(config);
+  s += snprintf(s, end - s, "create,statistics=(fast),cache_size=%jd,%s",
+                peek_option(globals.cache_size, (intmax_t)1 << 30),
+                durability_config);
+  if (globals.log_compressor != UNSET)
+    s += snprintf(s, end - s, ",log=(%s%scompressor=%s)", wal_config,
+                  *wal_config ? "," : "",
+                  log_compressors[globals.log_compressor]);
+  else if (*wal_config)
+    s += snprintf(s, end - s, ",log=(%s)", wal_config);
+  if (globals.eviction_threads_min != UNSET ||
+      globals.eviction_threads_max != UNSET) {
+    s += snprintf(s, end - s, ",eviction=(");
+    if (globals.eviction_threads_min != UNSET)
+      s += snprintf(s, end - s, "threads_min=%jd%s",
+                    globals.eviction_threads_min,
+                    (globals.eviction_threads_max != UNSET) ? "," : "");
+    if (globals.eviction_threads_max != UNSET)
+      s += snprintf(s, end - s, "threads_max=%jd",
+                    globals.eviction_threads_max);
+    s += snprintf(s, end - s, ")");
+  }
+  if (globals.eviction_target != UNSET)
+    s += snprintf(s, end - s, ",eviction_target=%jd", globals.eviction_target);
+  if (globals.eviction_trigger != UNSET)
+    s += snprintf(s, end - s, ",eviction_trigger=%jd",
+                  globals.eviction_trigger);
+  if (globals.eviction_dirty_target != UNSET)
+    s += snprintf(s, end - s, ",eviction_dirty_target=%jd",
+                  globals.eviction_dirty_target);
+  if (globals.eviction_dirty_trigger != UNSET)
+    s += snprintf(s, end - s, ",eviction_dirty_trigger=%jd",
+                  globals.eviction_dirty_trigger);
+  if (globals.checkpoint_wait != UNSET)
+    s += snprintf(s, end - s, ",checkpoint=(wait=%jd)",
+                  globals.checkpoint_wait);
+  if (s >= end) {
+    ia_log("error: %s(): too long config", __func__);
+    return -1;
+  }
+  ia_log("wiredtiger: %s", config);
+
   int rc = wiredtiger_open(datadir, NULL, config, &self->conn);
   if (rc != 0)
     goto bailout;
@@ -86,15 +339,35 @@ static int ia_wt_open(const char *datadir) {
 
   self->table_name = "table:test";
   snprintf(config, sizeof(config),
-           "split_pct=100,leaf_item_max=1KB,"
-           "type=lsm,internal_page_max=4KB,leaf_page_max=4KB");
+           "split_pct=100,leaf_item_max=1KB,type=%s,internal_page_max=%jd,"
+           "leaf_page_max=%jd,prefix_compression=%s",
+           table_types[peek_option(globals.table_type, 0 /* lsm */)],
+           peek_option(globals.internal_page, 4096),
+           peek_option(globals.leaf_page, 4096),
+           (globals.prefix_compression == ia_opt_bool_on) ? "true" : "false");
+  ia_log("wiredtiger: %s", config);
   rc = session->create(session, self->table_name, config);
   if (rc != 0)
     goto bailout;
 
   rc = session->close(session, NULL);
+  session = NULL;
   if (rc != 0)
     goto bailout;
+
+  if (self->need_checkpoints) {
+    pthread_mutex_init(&self->mutex, NULL);
+    pthread_cond_init(&self->cond, NULL);
+    rc = pthread_create(&self->checkpointer, NULL, ia_wt_checkpointer, self);
+    if (rc != 0) {
+      ia_log("error: %s, pthread_create() %s (%d)", __func__, strerror(rc),
+             rc);
+      pthread_cond_destroy(&self->cond);
+      pthread_mutex_destroy(&self->mutex);
+      self->need_checkpoints = 0;
+      return -1;
+    }
+  }
   return 0;
 
 bailout:
@@ -110,6 +383,15 @@ static int ia_wt_close(void) {
   iaprivate *self = ioarena.driver->priv;
   if (self) {
     ioarena.driver->priv = NULL;
+    if (self->need_checkpoints) {
+      pthread_mutex_lock(&self->mutex);
+      self->stop = 1;
+      pthread_cond_signal(&self->cond);
+      pthread_mutex_unlock(&self->mutex);
+      pthread_join(self->checkpointer, NULL);
+      pthread_cond_destroy(&self->cond);
+      pthread_mutex_destroy(&self->mutex);
+    }
     if (self->conn)
       self->conn->close(self->conn, NULL);
     free(self);
@@ -157,6 +439,11 @@ static int ia_wiredtiger_begin(iacontext *ctx, iabenchmark step) {
   int rc = 0;
 
   switch (step) {
+  case IA_SET:
+  case IA_DELETE:
+    if (ioarena.conf.txn_length < 2)
+      break;
+    /* fallthrough */
   case IA_BATCH:
   case IA_CRUD:
     rc =
@@ -165,8 +452,6 @@ static int ia_wiredtiger_begin(iacontext *ctx, iabenchmark step) {
       goto bailout;
     ctx->transaction = 1;
 
-  case IA_SET:
-  case IA_DELETE:
   case IA_GET:
     break;
 
@@ -174,6 +459,12 @@ static int ia_wiredtiger_begin(iacontext *ctx, iabenchmark step) {
     rc = ctx->cursor->reset(ctx->cursor);
     if (rc != 0)
       goto bailout;
+    ctx->seeked = 0;
+    /* the scan runs within a snapshot, like with other MVCC engines */
+    rc = ctx->session->begin_transaction(ctx->session, "isolation=snapshot");
+    if (rc != 0)
+      goto bailout;
+    ctx->transaction = 1;
     break;
 
   default:
@@ -189,29 +480,47 @@ bailout:
   return -1;
 }
 
+/* a write-write conflict rolls the transaction back entirely, then
+ * the benchmark retries it, see ia_backoff() */
+static int ia_wiredtiger_conflict(iacontext *ctx) {
+  if (ctx->transaction) {
+    (void)ctx->session->rollback_transaction(ctx->session, NULL);
+    ctx->transaction = 0;
+  }
+  return EBUSY;
+}
+
 static int ia_wiredtiger_done(iacontext *ctx, iabenchmark step) {
-  iaprivate *self = ioarena.driver->priv;
   int rc = 0;
 
   switch (step) {
   case IA_BATCH:
   case IA_CRUD:
+  case IA_DELETE:
+  case IA_SET:
     if (ctx->transaction) {
       rc = ctx->session->commit_transaction(ctx->session, NULL);
+      if (rc == WT_ROLLBACK) {
+        ctx->transaction = 0 /* the failed commit is rolled back */;
+        return EBUSY;
+      }
       if (rc != 0)
         goto bailout;
       ctx->transaction = 0;
     }
     /* fallthrough */
-  case IA_DELETE:
-  case IA_SET:
-    if (self->need_checkpoints && rc == 0)
-      rc = ctx->session->checkpoint(ctx->session, NULL);
-    /* fallthrough */
-  case IA_ITERATE:
   case IA_GET:
     break;
 
+  case IA_ITERATE:
+    if (ctx->transaction) {
+      rc = ctx->session->rollback_transaction(ctx->session, NULL);
+      ctx->transaction = 0;
+      if (rc != 0)
+        goto bailout;
+    }
+    break;
+
   default:
     assert(0);
     rc = -1;
@@ -229,6 +538,24 @@ bailout:
   return -1;
 }
 
+static int ia_wiredtiger_seek(iacontext *ctx, iakv *kv) {
+  WT_ITEM k;
+  int exact;
+  k.data = kv->k;
+  k.size = kv->ksize;
+  ctx->cursor->set_key(ctx->cursor, &k);
+  int rc = ctx->cursor->search_near(ctx->cursor, &exact);
+  if (rc == WT_NOTFOUND)
+    return ENOENT;
+  if (rc != 0) {
+    ia_log("error: %s, %s (%d)", __func__, wiredtiger_strerror(rc), rc);
+    return -1;
+  }
+  /* a smaller key is just before the wanted one */
+  ctx->seeked = exact >= 0;
+  return 0;
+}
+
 static int ia_wiredtiger_next(iacontext *ctx, iabenchmark step, iakv *kv) {
   WT_ITEM k, v;
   int rc = 0;
@@ -242,6 +569,8 @@ static int ia_wiredtiger_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     ctx->cursor->set_key(ctx->cursor, &k);
     ctx->cursor->set_value(ctx->cursor, &v);
     rc = ctx->cursor->insert(ctx->cursor);
+    if (rc == WT_ROLLBACK)
+      return ia_wiredtiger_conflict(ctx);
     if (rc != 0)
       goto bailout;
     break;
@@ -251,6 +580,8 @@ static int ia_wiredtiger_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     k.size = kv->ksize;
     ctx->cursor->set_key(ctx->cursor, &k);
     rc = ctx->cursor->remove(ctx->cursor);
+    if (rc == WT_ROLLBACK)
+      return ia_wiredtiger_conflict(ctx);
     if (rc != 0)
       goto bailout;
     break;
@@ -272,7 +603,8 @@ static int ia_wiredtiger_next(iacontext *ctx, iabenchmark step, iakv *kv) {
     break;
 
   case IA_ITERATE:
-    rc = ctx->cursor->next(ctx->cursor);
+    rc = ctx->seeked ? 0 : ctx->cursor->next(ctx->cursor);
+    ctx->seeked = 0;
     if (rc) {
       if (rc != WT_NOTFOUND)
         goto bailout;
@@ -304,13 +636,21 @@ bailout:
   return -1;
 }
 
+static const char *ia_wt_version(void) {
+  return wiredtiger_version(NULL, NULL, NULL);
+}
+
 iadriver ia_wt = {.name = "wiredtiger",
                   .priv = NULL,
                   .open = ia_wt_open,
                   .close = ia_wt_close,
+                  .version = ia_wt_version,
+                  .option = ia_wt_option,
+                  .counters = ia_wt_counters,
 
                   .thread_new = ia_wiredtiger_thread_new,
                   .thread_dispose = ia_wiredtiger_thread_dispose,
                   .begin = ia_wiredtiger_begin,
                   .next = ia_wiredtiger_next,
+                  .seek = ia_wiredtiger_seek,
                   .done = ia_wiredtiger_done};
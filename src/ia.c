@@ -39,6 +39,7 @@ int ia_init(ia *a, int argc, char **argv) {
     return -1;
 
   a->before_open_ram = before_open.ram;
+  a->before_open_mem = before_open.mem;
   for (struct iaoption *drv_opt = a->conf.drv_opts; drv_opt;
        drv_opt = drv_opt->next) {
     rc = a->driver->option(NULL, drv_opt->arg);
@@ -49,6 +50,10 @@ int ia_init(ia *a, int argc, char **argv) {
     }
   }
 
+  /* the crash-recovery test opens the database in the child processes */
+  if (a->conf.crashes)
+    return 0;
+
   rc = a->driver->open(a->datadir);
   if (rc == -1)
     return -1;
@@ -58,6 +63,8 @@ int ia_init(ia *a, int argc, char **argv) {
 void ia_free(ia *a) {
   if (a->driver)
     a->driver->close();
+  free(a->scan_records);
+  a->scan_records = NULL;
   ia_configfree(&a->conf);
 }
 
@@ -87,7 +94,8 @@ static void ia_sync_fihish(ia *a) {
 static void *ia_doer_thread(void *arg) {
   iadoer *doer = (iadoer *)arg;
   ia_sync_start(&ioarena);
-  int rc = ia_doer_fulfil(doer);
+  /* the round could be failed before the start, see ia_round() */
+  int rc = ioarena.failed ? 0 : ia_doer_fulfil(doer);
   if (rc)
     ioarena.failed = rc;
   ia_doer_destroy(doer);
@@ -96,6 +104,54 @@ static void *ia_doer_thread(void *arg) {
   return NULL;
 }
 
+/* The long-lived reader pins a snapshot by an iteration which is paused at
+ * its first record, before the others start and until -H elapses or the
+ * round is over. So MVCC engines can't reclaim the pages freed meanwhile,
+ * which shows up in the timeline as the database growth. */
+static void *ia_pinner_thread(void *arg) {
+  (void)arg;
+  iacontext *ctx = ioarena.driver->thread_new();
+  int rc = ctx ? 0 : -1;
+  for (struct iaoption *drv_opt = ioarena.conf.drv_opts; drv_opt && !rc;
+       drv_opt = drv_opt->next)
+    rc = ioarena.driver->option(ctx, drv_opt->arg);
+  if (!rc)
+    rc = ioarena.driver->begin(ctx, IA_ITERATE);
+  if (!rc) {
+    iakv a;
+    a.k = a.v = NULL;
+    a.ksize = a.vsize = 0;
+    rc = ioarena.driver->next(ctx, IA_ITERATE, &a);
+    if (rc == ENOENT)
+      rc = 0;
+  }
+  if (rc) {
+    ia_log("error: pinned reader failed (%d)", rc);
+    ioarena.failed = rc;
+  }
+
+  const ia_timestamp_t start = ia_timestamp_ns();
+  const ia_timestamp_t until =
+      (ioarena.conf.pin_ms < 0) ? 0 : start + ioarena.conf.pin_ms * MS;
+  ia_sync_start(&ioarena);
+  while (!ioarena.pin_release && (!until || ia_timestamp_ns() < until)) {
+    struct timespec ts = {.tv_sec = 0, .tv_nsec = MS};
+    nanosleep(&ts, NULL);
+  }
+
+  if (!rc) {
+    rc = ioarena.driver->done(ctx, IA_ITERATE);
+    ia_log("pinned reader: the snapshot was held for %.3f s",
+           (ia_timestamp_ns() - start) / (double)S);
+    if (rc)
+      ioarena.failed = rc;
+  }
+  if (ctx)
+    ioarena.driver->thread_dispose(ctx);
+  return NULL;
+}
+
+/* the nth is the number of the doers which were spawned */
 static int ia_spread(int count, int *nth, long *rotator, long set,
                      int *key_space) {
   int n;
@@ -124,30 +180,41 @@ static int ia_spread(int count, int *nth, long *rotator, long set,
         *key_space += 1;
     }
 
-    *nth += 1;
-    if (ia_doer_init(doer, *nth, mask, *key_space, *nth))
+    const int id = *nth + 1;
+    if (ia_doer_init(doer, id, mask, *key_space, id)) {
+      free(doer);
       return -1;
+    }
 
     pthread_t thread;
     int rc = pthread_create(&thread, NULL, ia_doer_thread, doer);
-    if (rc)
+    if (rc) {
+      ia_doer_destroy(doer);
+      free(doer);
       return rc;
+    }
+    pthread_detach(thread);
+    *nth = id;
 
     *rotator &= ~mask;
   }
   return 0;
 }
 
-int ia_run(ia *a) {
+static int ia_round(ia *a, int round, int repeat) {
   long set_rd = 0;
   long set_wr = 0;
   iabenchmark bench;
+
+  ia_histogram_rewind();
+  a->doers_done = 0;
+  a->failed = 0;
   for (bench = IA_SET; bench < IA_MAX; bench++) {
     if (!a->conf.benchmark_list[bench])
       continue;
 
     ia_histogram_enable(bench);
-    if (bench == IA_ITERATE || bench == IA_GET)
+    if (bench == IA_ITERATE || bench == IA_GET || bench == IA_GETMISS)
       set_rd |= 1l << bench;
     else
       set_wr |= 1l << bench;
@@ -172,16 +239,45 @@ int ia_run(ia *a) {
   if (set_wr & bench_mask_2keyspace)
     key_nspaces += key_nspaces;
 
-  int rc =
-      ia_kvgen_setup(!ioarena.conf.binary, ioarena.conf.ksize, key_nspaces,
-                     key_nsectors, ioarena.conf.count, ioarena.conf.kvseed);
+  /* the misses and the contended keys are drawn from the reserved key
+   * spaces above any of the writers' ones, see ia_doer_init(). These don't
+   * change the generator's width, so the keys stay the same with -M/-X. */
+  const int with_miss = (set_rd & (1l << IA_GETMISS)) ||
+                        ((set_rd & (1l << IA_GET)) && a->conf.miss_ratio);
+  const int with_shared = a->conf.shared_ratio &&
+                          (set_wr & (1l << IA_SET | 1l << IA_UPDATE));
+
+  /* the soak's churn slides the live keys over a twice larger range */
+  int rc = ia_kvgen_setup(!ioarena.conf.binary, ioarena.conf.ksize,
+                          key_nspaces, 2, key_nsectors,
+                          ioarena.conf.count * (a->conf.soak.duration ? 2 : 1),
+                          ioarena.conf.kvseed, ioarena.conf.reserve,
+                          ioarena.conf.key_order, ia_key_window(&a->conf),
+                          ioarena.conf.value_ratio, ioarena.conf.key_format,
+                          ioarena.conf.key_tenants, ioarena.conf.key_tables);
   if (rc) {
     ia_log("error: key-value generator setup failed, the options are correct?");
     return rc;
   }
+  a->miss_space = with_miss ? (int)ia_kvgen_reserved(0) : 0;
+  a->shared_space = with_shared ? (int)ia_kvgen_reserved(1) : 0;
+
+  a->scan_next = 0;
+  if (a->conf.scan_partitions && (set_rd & (1l << IA_ITERATE))) {
+    if (!a->driver->seek) {
+      ia_log("error: the '%s' driver doesn't support the partitioned scan",
+             a->driver->name);
+      return -1;
+    }
+    free(a->scan_records);
+    a->scan_records = calloc(a->conf.scan_partitions, sizeof(uintmax_t));
+    if (!a->scan_records)
+      return -1;
+  }
 
+  const int pinner = a->conf.pin_ms != 0;
   rc = pthread_barrier_init(&a->barrier_start, NULL,
-                            a->conf.rthr + a->conf.wthr + 1);
+                            a->conf.rthr + a->conf.wthr + pinner + 1);
   if (!rc)
     rc = pthread_barrier_init(&a->barrier_fihish, NULL,
                               a->conf.rthr + a->conf.wthr + 1);
@@ -191,66 +287,132 @@ int ia_run(ia *a) {
   }
 
   ia_histogram_csvopen(&a->conf);
+  ia_histogram_sampler_start();
+  a->deadline =
+      a->conf.soak.duration ? ia_timestamp_ns() + a->conf.soak.duration * S : 0;
+
+  pthread_t pinner_thread;
+  a->pin_release = 0;
+  if (pinner) {
+    rc = pthread_create(&pinner_thread, NULL, ia_pinner_thread, NULL);
+    if (rc)
+      goto bailout;
+  }
 
   int nth = 0;
   int key_space = 0;
   rc = ia_spread(a->conf.rthr, &nth, &set_rd, set_rd, &key_space);
-  if (rc)
-    goto bailout;
-
-  rc = ia_spread(a->conf.wthr, &nth, &set_wr, set_wr, &key_space);
-  if (rc)
+  if (!rc)
+    rc = ia_spread(a->conf.wthr, &nth, &set_wr, set_wr, &key_space);
+  if (rc) {
+    /* the spawned ones are waiting for the start barrier, which could
+     * not be completed anymore */
+    if (nth || pinner)
+      ia_fatal("unable to spawn the doers");
     goto bailout;
+  }
 
   iarusage rusage_start, rusage_fihish;
-  if (set_wr | set_rd) {
-    iadoer here;
-    if (ia_doer_init(&here, 0, set_wr | set_rd, 0, 0))
-      goto bailout;
-
+  iadoer here;
+  const long here_mask = set_wr | set_rd /* the rest for the main thread */;
+  const int here_ok = here_mask && !ia_doer_init(&here, 0, here_mask, 0, 0);
+  if (here_mask && !here_ok)
+    rc = -1;
+  if (!rc)
     rc = ia_get_rusage(&rusage_start, a->datadir);
-    if (rc)
-      goto bailout;
+  if (rc) {
+    /* the doers and the pinner are released to quit at once */
+    a->failed = rc;
+    a->pin_release = 1;
+  }
 
-    ia_sync_start(a);
+  ia_sync_start(a);
+  if (here_ok && !rc)
     rc = ia_doer_fulfil(&here);
-    ia_sync_fihish(a);
-
-    if (rc)
-      goto bailout;
-
-    rc = ia_get_rusage(&rusage_fihish, a->datadir);
-    if (rc)
-      goto bailout;
-
+  ia_sync_fihish(a);
+  ia_histogram_sampler_stop();
+  if (pinner) {
+    a->pin_release = 1;
+    pthread_join(pinner_thread, NULL);
+  }
+  if (here_ok)
     ia_doer_destroy(&here);
-  } else {
-    rc = ia_get_rusage(&rusage_start, a->datadir);
-    if (rc)
-      goto bailout;
-
-    ia_sync_start(a);
-    ia_sync_fihish(a);
 
+  if (!rc)
     rc = ia_get_rusage(&rusage_fihish, a->datadir);
-    if (rc)
-      goto bailout;
-  }
-
-  if (a->failed)
+  if (!rc && a->failed)
+    rc = a->failed;
+  if (rc)
     goto bailout;
 
   ia_histogram_checkpoint(0);
   ia_log("complete.");
   ia_histogram_print(&a->conf);
+  if (a->conf.soak.duration)
+    ia_soak_print(&a->conf);
+  ia_scan_print();
 
   rusage_start.ram = a->before_open_ram;
   rusage_start.disk = 0;
+  rusage_start.disk_alloc = 0;
   ia_histogram_rusage(&a->conf, &rusage_start, &rusage_fihish);
   ia_histogram_csvclose();
 
+  if (a->conf.sweep.var != IA_SWEEP_NONE)
+    if (ia_sweep_collect(&a->conf, round, repeat, &rusage_start,
+                         &rusage_fihish))
+      ia_log("error: sweep, out of memory");
+  ia_report_round(&a->conf, round, repeat, &rusage_start, &rusage_fihish);
+
+  pthread_barrier_destroy(&a->barrier_start);
+  pthread_barrier_destroy(&a->barrier_fihish);
   return 0;
 
 bailout:
-  exit(EXIT_FAILURE);
+  ia_log("error: the round is failed (%d)", rc);
+  ia_histogram_sampler_stop();
+  ia_histogram_csvclose();
+  pthread_barrier_destroy(&a->barrier_start);
+  pthread_barrier_destroy(&a->barrier_fihish);
+  return rc ? rc : -1;
+}
+
+static int ia_repeat(ia *a, int round) {
+  char tag[sizeof(a->round_tag)];
+  strcpy(tag, a->round_tag);
+
+  int rc = 0;
+  for (int repeat = 0; !rc && repeat < a->conf.nrepeat; ++repeat) {
+    if (a->conf.nrepeat > 1) {
+      snprintf(a->round_tag, sizeof(a->round_tag), "%.16s%srun%d", tag,
+               tag[0] ? "_" : "", repeat + 1);
+      ia_log("repeat: %d of %d", repeat + 1, a->conf.nrepeat);
+    }
+    rc = ia_round(a, round, repeat);
+  }
+
+  strcpy(a->round_tag, tag);
+  return rc;
+}
+
+int ia_run(ia *a) {
+  int rc = 0;
+  if (a->conf.json_path && ia_report_open(&a->conf, a->datadir))
+    return -1;
+
+  if (a->conf.crashes)
+    rc = ia_crash_run(a);
+  else if (a->conf.sweep.var == IA_SWEEP_NONE)
+    rc = ia_repeat(a, 0);
+  else {
+    for (int nth = 0; !rc && nth < a->conf.sweep.npoints; ++nth) {
+      ia_sweep_apply(&a->conf, nth);
+      rc = ia_repeat(a, nth);
+    }
+    if (!rc)
+      ia_sweep_print(&a->conf);
+  }
+
+  ia_report_close();
+  return rc;
 }
@@ -17,6 +17,7 @@ typedef struct ia ia;
 
 #include "ia_config.h"
 #include "ia_driver.h"
+#include "ia_rusage.h"
 
 struct ia {
   iadriver *driver;
@@ -26,7 +27,15 @@ struct ia {
   volatile int doers_done;
   pthread_barrier_t barrier_fihish;
   size_t before_open_ram;
+  iamemusage before_open_mem;
   char datadir[PATH_MAX];
+  char round_tag[32];
+  ia_timestamp_t deadline /* of the soak, zero otherwise */;
+  int miss_space /* the key space which is never written */;
+  int shared_space /* the key space which all writers contend for */;
+  volatile unsigned scan_next /* the queue of the scan partitions */;
+  uintmax_t *scan_records /* per partition */;
+  volatile int pin_release /* the round is over, see ia_pinner_thread() */;
   int failed;
 };
 
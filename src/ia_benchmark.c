@@ -9,10 +9,12 @@
 #include "ioarena.h"
 
 const long bench_mask_read = 0 | 1ull << IA_BATCH | 1ull << IA_CRUD |
-                             1ull << IA_ITERATE | 1ull << IA_GET;
+                             1ull << IA_ITERATE | 1ull << IA_GET |
+                             1ull << IA_GETMISS;
 
-const long bench_mask_write =
-    0 | 1ull << IA_SET | 1ull << IA_BATCH | 1ull << IA_CRUD | 1ull << IA_DELETE;
+const long bench_mask_write = 0 | 1ull << IA_SET | 1ull << IA_UPDATE |
+                              1ull << IA_BATCH | 1ull << IA_CRUD |
+                              1ull << IA_DELETE;
 
 const long bench_mask_2keyspace = 0 | 1ull << IA_BATCH | 1ull << IA_CRUD;
 
@@ -21,6 +23,52 @@ static void ia_keynotfound(iadoer *doer, const char *op, iakv *k) {
          doer->key_space, doer->key_sequence);
 }
 
+/* a conflict has been rolled back by the driver, which signals it by
+ * EBUSY, then the whole transaction is retried after an exponential backoff
+ * with jitter, from a microsecond up to about a millisecond. The aborted
+ * attempts are counted, but their time goes to the latency of the final one.
+ */
+#define IA_RETRY_MAX 64
+
+static int ia_backoff(iadoer *doer, int attempt) {
+  ia_histogram_abort(&doer->hg);
+  if (attempt > IA_RETRY_MAX) {
+    ia_log("error: doer.%d gave up after %d conflicts in a row", doer->nth,
+           IA_RETRY_MAX);
+    return -1;
+  }
+
+  doer->jitter ^= doer->jitter << 13;
+  doer->jitter ^= doer->jitter >> 17;
+  doer->jitter ^= doer->jitter << 5;
+  const long ceil = 1000l << (attempt < 10 ? attempt : 10);
+  struct timespec ts = {.tv_sec = 0,
+                        .tv_nsec = ceil / 2 + doer->jitter % (ceil / 2)};
+  nanosleep(&ts, NULL);
+  return 0;
+}
+
+/* The contention sends the -X share of writes to the small set of hot keys,
+ * which is the same for all writers. */
+static struct ia_kvgen *ia_write_gen(iadoer *doer) {
+  if (doer->gen_shared) {
+    doer->shared_acc += ioarena.conf.shared_ratio;
+    if (doer->shared_acc >= 100) {
+      doer->shared_acc -= 100;
+      return doer->gen_shared;
+    }
+  }
+  return doer->gen_a;
+}
+
+/* the contended writes leave some of the writer's own keys unwritten,
+ * as well as the soak's churn deletes the oldest ones */
+static int ia_miss_expected(iabenchmark bench) {
+  if (bench == IA_GET && ioarena.deadline)
+    return 1;
+  return ioarena.shared_space && (bench == IA_GET || bench == IA_DELETE);
+}
+
 static int ia_quadruple(iadoer *doer, iakv *a, iakv *b) {
   int rc = ioarena.driver->next(doer->ctx, IA_SET, b);
   if (!rc)
@@ -44,6 +92,312 @@ static int ia_quadruple(iadoer *doer, iakv *a, iakv *b) {
   return rc;
 }
 
+/* Read-modify-write of an existing key within a single write transaction:
+ * gets the value, increments the bytes of its 8-byte slice and puts it back.
+ * The slice moves along the value by the operations. A driver could do the
+ * same by the engine's native merge instead. */
+static int ia_update(iadoer *doer, uintmax_t i) {
+  iakv a, b;
+  struct ia_kvgen *gen = ia_write_gen(doer);
+  if (ia_kvgen_get(gen, &a, 0))
+    return -1;
+  const size_t length = (a.vsize < 8) ? a.vsize : 8;
+  const size_t offset = (i * length) % (a.vsize - length + 1);
+
+  ia_timestamp_t t0 = ia_timestamp_ns();
+  int rc, rc2, merged, attempt = 0;
+retry:
+  rc = ioarena.driver->begin(doer->ctx, IA_CRUD);
+  merged = 0;
+  if (!rc && ioarena.driver->merge) {
+    rc = ioarena.driver->merge(doer->ctx, &a, offset, length);
+    merged = rc != ENOSYS;
+    if (!merged)
+      rc = 0;
+  }
+  if (!rc && !merged) {
+    b.k = a.k;
+    b.ksize = a.ksize;
+    b.v = NULL;
+    b.vsize = 0;
+    rc = ioarena.driver->next(doer->ctx, IA_GET, &b);
+    if (rc == ENOENT && gen == doer->gen_shared)
+      rc = 0 /* the hot keys are inserted by the first update */;
+    if (rc == ENOENT) {
+      ia_keynotfound(doer, "update.get", &a);
+      if (ioarena.conf.ignore_keynotfound)
+        rc = 0;
+    }
+    if (!rc) {
+      /* not all drivers return the value, then it is rendered anew */
+      if (b.v && b.vsize == a.vsize)
+        memcpy(doer->update_buf, b.v, a.vsize);
+      else if (a.v)
+        memcpy(doer->update_buf, a.v, a.vsize);
+      else if (a.vsize)
+        ia_kv_value(&a, doer->update_buf);
+      for (size_t j = offset; j < offset + length; ++j)
+        doer->update_buf[j] += 1;
+      b.v = doer->update_buf;
+      b.vsize = a.vsize;
+      rc = ioarena.driver->next(doer->ctx, IA_SET, &b);
+    }
+  }
+  rc2 = (rc == EBUSY) ? 0 : ioarena.driver->done(doer->ctx, IA_CRUD);
+  if ((rc ? rc : rc2) == EBUSY && !ia_backoff(doer, ++attempt))
+    goto retry;
+  ia_histogram_add(&doer->hg, t0, 1, (a.ksize + a.vsize) * (merged ? 1 : 2));
+  return rc ? rc : rc2;
+}
+
+/* The soak keeps the live dataset of a fixed size, i.e. once the initial
+ * <number_of_operations> keys are inserted, the oldest key is deleted for
+ * every new one, at the given rate in total for all writers. */
+static void ia_churn_pace(iadoer *doer) {
+  if (!ioarena.conf.soak.rate || doer->churn_inserted < ioarena.conf.count)
+    return;
+
+  const int writers = ioarena.conf.wthr ? ioarena.conf.wthr : 1;
+  const ia_timestamp_t now = ia_timestamp_ns();
+  if (doer->churn_due + S < now)
+    doer->churn_due = now /* no bursts after a stall */;
+  else if (doer->churn_due > now) {
+    const ia_timestamp_t pause = doer->churn_due - now;
+    struct timespec ts = {.tv_sec = pause / S, .tv_nsec = pause % S};
+    nanosleep(&ts, NULL);
+  }
+  doer->churn_due += S * writers / ioarena.conf.soak.rate;
+}
+
+static int ia_churn(iadoer *doer) {
+  if (++doer->churn_inserted <= ioarena.conf.count)
+    return 0;
+
+  iakv tail;
+  if (ia_kvgen_get(doer->churn_tail, &tail, 1))
+    return -1;
+  int rc = ioarena.driver->next(doer->ctx, IA_DELETE, &tail);
+  if (rc == ENOENT) {
+    ia_keynotfound(doer, "soak.del", &tail);
+    if (ioarena.conf.ignore_keynotfound)
+      rc = 0;
+  } else if (rc == 0)
+    ia_histogram_churn();
+  return rc;
+}
+
+/* The get-miss draws all keys from the never written key space, and the get
+ * spreads such misses evenly by the -M ratio. */
+static struct ia_kvgen *ia_lookup_gen(iadoer *doer, iabenchmark bench) {
+  if (bench == IA_GETMISS)
+    return doer->gen_miss;
+  if (ioarena.conf.miss_ratio) {
+    doer->miss_acc += ioarena.conf.miss_ratio;
+    if (doer->miss_acc >= 100) {
+      doer->miss_acc -= 100;
+      return doer->gen_miss;
+    }
+  }
+  return doer->gen_a;
+}
+
+static int ia_soak_over(const iadoer *doer) {
+  return ioarena.deadline && doer->hg.end_ns >= ioarena.deadline;
+}
+
+static int ia_txn_write(iadoer *doer, iabenchmark bench, uintmax_t *i,
+                        struct ia_kvpool **pool) {
+  uintmax_t left = ioarena.conf.count - *i;
+  int n = ioarena.conf.txn_length, j;
+  size_t volume = 0;
+  iakv a;
+
+  if ((uintmax_t)n > left)
+    n = left;
+  const int churn = bench == IA_SET && doer->churn_head;
+  struct ia_kvgen *gen = doer->gen_a;
+  if (churn)
+    gen = doer->churn_head;
+  else if (bench == IA_SET)
+    gen = ia_write_gen(doer);
+  int rc = ia_kvpool_init(pool, gen, n), rc2, attempt = 0;
+  if (rc)
+    return rc;
+
+  for (j = 0; churn && j < n; ++j)
+    ia_churn_pace(doer);
+  ia_timestamp_t t0 = ia_timestamp_ns();
+retry:
+  volume = 0;
+  rc = ioarena.driver->begin(doer->ctx, bench);
+  for (j = 0; !rc && j < n; ++j) {
+    if (ia_kvpool_pull(*pool, &a)) {
+      rc = -1 /* the transaction is completed by done() below anyway */;
+      break;
+    }
+    if (bench == IA_DELETE)
+      a.vsize = 0;
+    rc = ioarena.driver->next(doer->ctx, bench, &a);
+    if (rc == ENOENT && ia_miss_expected(bench))
+      rc = 0;
+    if (rc == ENOENT) {
+      ia_keynotfound(doer, ia_benchmarkof(bench), &a);
+      if (ioarena.conf.ignore_keynotfound)
+        rc = 0;
+    }
+    if (!rc && churn)
+      rc = ia_churn(doer);
+    volume += a.ksize + a.vsize;
+  }
+  rc2 = (rc == EBUSY) ? 0 : ioarena.driver->done(doer->ctx, bench);
+  if ((rc ? rc : rc2) == EBUSY && !churn && !ia_backoff(doer, ++attempt)) {
+    ia_kvpool_rewind(*pool);
+    goto retry;
+  }
+  ia_histogram_add(&doer->hg, t0, j, volume);
+  *i += j;
+  return rc ? rc : rc2;
+}
+
+/* Many lookups within a single read snapshot, each one is timestamped
+ * individually, so the snapshot acquisition cost shows up in the throughput
+ * but not in the latency. */
+static int ia_txn_read(iadoer *doer, iabenchmark bench, uintmax_t *i) {
+  const uintmax_t left = ioarena.conf.count - *i;
+  uintmax_t n = ioarena.conf.get_length, j;
+  ia_timestamp_t deadline = 0;
+
+  if (n == 0 || n > left)
+    n = left;
+  if (ioarena.conf.get_budget_ms)
+    deadline = ia_timestamp_ns() + ioarena.conf.get_budget_ms * MS;
+
+  int rc = ioarena.driver->begin(doer->ctx, IA_GET);
+  for (j = 0; !rc && j < n;) {
+    iakv a;
+    struct ia_kvgen *gen = ia_lookup_gen(doer, bench);
+    if (ia_kvgen_get(gen, &a, 1)) {
+      rc = -1;
+      break;
+    }
+    ia_timestamp_t t0 = ia_timestamp_ns();
+    int attempt = 0;
+    while ((rc = ioarena.driver->next(doer->ctx, IA_GET, &a)) == EBUSY) {
+      /* a busy lookup (e.g. by a sqlite's writer) has its snapshot rolled
+       * back, so it is retried within a new one after the backoff */
+      (void)ioarena.driver->done(doer->ctx, IA_GET);
+      if (ia_backoff(doer, ++attempt))
+        return -1;
+      rc = ioarena.driver->begin(doer->ctx, IA_GET);
+      if (rc)
+        return rc;
+    }
+    ia_histogram_add(&doer->hg, t0, 1, a.ksize + a.vsize);
+    ++j;
+    if (rc == ENOENT && gen == doer->gen_miss)
+      rc = 0;
+    if (rc == ENOENT && ia_miss_expected(IA_GET))
+      rc = 0;
+    if (rc == ENOENT) {
+      ia_keynotfound(doer, ia_benchmarkof(IA_GET), &a);
+      if (ioarena.conf.ignore_keynotfound)
+        rc = 0;
+    }
+    if (deadline && doer->hg.end_ns >= deadline)
+      break;
+  }
+  int rc2 = ioarena.driver->done(doer->ctx, IA_GET);
+  *i += j;
+  return rc ? rc : rc2;
+}
+
+/* The partitioned scan: the readers take the key ranges from the common
+ * queue, the faster ones take more, until all ranges are scanned. Then the
+ * continuous and soak modes go round the ranges once again. The records
+ * are capped by -n per range, the same as for the plain iterate. */
+static int ia_scan_partition(iadoer *doer, uintmax_t *i) {
+  const unsigned parts = ioarena.conf.scan_partitions;
+  unsigned nth = __sync_fetch_and_add(&ioarena.scan_next, 1);
+  const int again = nth >= parts;
+  if (again) {
+    if (!ioarena.conf.continuous_completing && !ioarena.deadline) {
+      *i = ioarena.conf.count;
+      return 0;
+    }
+    nth %= parts;
+  }
+
+  char *const lower = malloc(2 * (ioarena.conf.ksize + 8));
+  if (!lower)
+    return -1;
+  char *const upper = lower + ioarena.conf.ksize + 8;
+  const size_t len = ia_kv_split(nth, parts, lower);
+  const int last = nth + 1 == parts;
+  if (!last)
+    ia_kv_split(nth + 1, parts, upper);
+
+  uintmax_t n = 0;
+  iakv a;
+  ia_timestamp_t t0 = ia_timestamp_ns();
+  int rc = ioarena.driver->begin(doer->ctx, IA_ITERATE);
+  if (!rc && nth > 0) {
+    a.k = lower;
+    a.ksize = len;
+    a.v = NULL;
+    a.vsize = 0;
+    rc = ioarena.driver->seek(doer->ctx, &a);
+  }
+  while (rc == 0 && n < ioarena.conf.count) {
+    a.k = a.v = NULL;
+    a.ksize = a.vsize = 0;
+    rc = ioarena.driver->next(doer->ctx, IA_ITERATE, &a);
+    if (rc || (!last && a.k && a.ksize >= len && memcmp(a.k, upper, len) >= 0))
+      break;
+    ia_histogram_add(&doer->hg, t0, 1, a.ksize + a.vsize);
+    ++n;
+    t0 = ia_timestamp_ns();
+  }
+  if (rc == ENOENT)
+    rc = 0;
+  if (!rc)
+    rc = ioarena.driver->done(doer->ctx, IA_ITERATE);
+
+  free(lower);
+  __sync_fetch_and_add(&ioarena.scan_records[nth], n);
+  if (again)
+    *i = ioarena.conf.count;
+  return rc;
+}
+
+/* the max to the average of records per partition, zero if no records */
+double ia_scan_skew(uintmax_t *min, double *avg, uintmax_t *max) {
+  const unsigned parts = ioarena.conf.scan_partitions;
+  uintmax_t sum = 0;
+  *min = ~0ull;
+  *max = 0;
+  for (unsigned nth = 0; nth < parts; ++nth) {
+    const uintmax_t n = ioarena.scan_records[nth];
+    *min = (*min < n) ? *min : n;
+    *max = (*max > n) ? *max : n;
+    sum += n;
+  }
+  *avg = sum / (double)parts;
+  return sum ? *max / *avg : 0;
+}
+
+void ia_scan_print(void) {
+  if (!ioarena.scan_records)
+    return;
+
+  uintmax_t min, max;
+  double avg;
+  const double skew = ia_scan_skew(&min, &avg, &max);
+  printf("\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> "
+         "scan\n");
+  printf("partitions: %d, records min %ju, avg %.1f, max %ju, skew %.2f\n",
+         ioarena.conf.scan_partitions, min, avg, max, skew);
+}
+
 static int ia_run_benchmark(iadoer *doer, iabenchmark bench) {
   int rc = 0, rc2;
   uintmax_t i;
@@ -55,25 +409,66 @@ static int ia_run_benchmark(iadoer *doer, iabenchmark bench) {
 
   ia_histogram_reset(&doer->hg, bench);
 
-  for (i = 0; rc == 0 && i < ioarena.conf.count;) {
+  for (i = 0; rc == 0 && i < ioarena.conf.count && !ia_soak_over(doer);) {
     ia_timestamp_t t0;
     iakv a, b;
-    int j;
+    int j, attempt;
+    int churn;
+    struct ia_kvgen *gen;
 
     switch (bench) {
     case IA_SET:
     case IA_DELETE:
+      if (ioarena.conf.txn_length > 1) {
+        rc = ia_txn_write(doer, bench, &i, &pool_a);
+        if (rc)
+          goto bailout;
+        break;
+      }
+      /* fallthrough */
     case IA_GET:
-      if (ia_kvgen_get(doer->gen_a, &a, bench != IA_SET))
+    case IA_GETMISS:
+      if ((bench == IA_GET || bench == IA_GETMISS) &&
+          (ioarena.conf.get_length != 1 || ioarena.conf.get_budget_ms)) {
+        rc = ia_txn_read(doer, bench, &i);
+        if (rc)
+          goto bailout;
+        break;
+      }
+      churn = bench == IA_SET && doer->churn_head;
+      gen = churn ? doer->churn_head : doer->gen_a;
+      if (bench == IA_SET && !churn)
+        gen = ia_write_gen(doer);
+      if (bench == IA_GET || bench == IA_GETMISS)
+        gen = ia_lookup_gen(doer, bench);
+      if (ia_kvgen_get(gen, &a, bench != IA_SET))
         goto bailout;
+      if (churn)
+        ia_churn_pace(doer);
 
+      /* the drivers know nothing about misses */
+      const iabenchmark op = (bench == IA_GETMISS) ? IA_GET : bench;
+      /* the churn's insert and delete are done within a single write
+       * transaction, the same way as for crud */
+      const iabenchmark step =
+          (churn && doer->churn_inserted >= ioarena.conf.count) ? IA_CRUD : op;
       t0 = ia_timestamp_ns();
-      rc = ioarena.driver->begin(doer->ctx, bench);
-      if (!rc)
-        rc = ioarena.driver->next(doer->ctx, bench, &a);
-      rc2 = ioarena.driver->done(doer->ctx, bench);
-      ia_histogram_add(&doer->hg, t0,
+      for (attempt = 0;;) {
+        rc = ioarena.driver->begin(doer->ctx, step);
+        if (!rc)
+          rc = ioarena.driver->next(doer->ctx, op, &a);
+        if (!rc && churn)
+          rc = ia_churn(doer);
+        rc2 = (rc == EBUSY) ? 0 : ioarena.driver->done(doer->ctx, step);
+        if (churn || (rc ? rc : rc2) != EBUSY || ia_backoff(doer, ++attempt))
+          break;
+      }
+      ia_histogram_add(&doer->hg, t0, 1,
                        bench == IA_DELETE ? a.ksize : a.ksize + a.vsize);
+      if (rc == ENOENT && gen == doer->gen_miss)
+        rc = 0;
+      if (rc == ENOENT && ia_miss_expected(bench))
+        rc = 0;
       if (rc == ENOENT) {
         ia_keynotfound(doer, ia_benchmarkof(bench), &a);
         if (ioarena.conf.ignore_keynotfound)
@@ -86,6 +481,13 @@ static int ia_run_benchmark(iadoer *doer, iabenchmark bench) {
       ++i;
       break;
 
+    case IA_UPDATE:
+      rc = ia_update(doer, i);
+      if (rc)
+        goto bailout;
+      ++i;
+      break;
+
     case IA_CRUD:
       if (ia_kvgen_get(doer->gen_a, &a, 0) || ia_kvgen_get(doer->gen_b, &b, 0))
         goto bailout;
@@ -95,7 +497,7 @@ static int ia_run_benchmark(iadoer *doer, iabenchmark bench) {
         rc = ia_quadruple(doer, &a, &b);
       if (!rc)
         rc = ioarena.driver->done(doer->ctx, IA_CRUD);
-      ia_histogram_add(&doer->hg, t0,
+      ia_histogram_add(&doer->hg, t0, 1,
                        a.ksize + a.vsize + b.ksize + b.vsize + a.ksize +
                            b.ksize + b.vsize);
       if (rc)
@@ -122,7 +524,7 @@ static int ia_run_benchmark(iadoer *doer, iabenchmark bench) {
       }
       if (!rc)
         rc = ioarena.driver->done(doer->ctx, IA_BATCH);
-      ia_histogram_add(&doer->hg, t0,
+      ia_histogram_add(&doer->hg, t0, j + (j < ioarena.conf.batch_length),
                        (a.ksize + a.vsize + b.ksize + b.vsize + a.ksize +
                         b.ksize + b.vsize) *
                            ioarena.conf.batch_length);
@@ -131,13 +533,19 @@ static int ia_run_benchmark(iadoer *doer, iabenchmark bench) {
       break;
 
     case IA_ITERATE:
+      if (ioarena.conf.scan_partitions) {
+        rc = ia_scan_partition(doer, &i);
+        if (rc)
+          goto bailout;
+        break;
+      }
       t0 = ia_timestamp_ns();
       rc = ioarena.driver->begin(doer->ctx, IA_ITERATE);
       while (rc == 0) {
         a.k = a.v = NULL;
         a.ksize = a.vsize = 0;
         rc = ioarena.driver->next(doer->ctx, IA_ITERATE, &a);
-        ia_histogram_add(&doer->hg, t0, a.ksize + a.vsize);
+        ia_histogram_add(&doer->hg, t0, 1, a.ksize + a.vsize);
         if (++i == ioarena.conf.count)
           break;
         t0 = ia_timestamp_ns();
@@ -180,22 +588,25 @@ int ia_doer_fulfil(iadoer *doer) {
     }
   }
 
+  /* the repeats (nrepeat) are done by whole rounds, see ia_run(),
+   * so here is just a single pass, which would be continued in the
+   * continuous completing mode until all other doers are done. */
   int count = 0, rc = 0;
-  for (count = 0; count < ioarena.conf.nrepeat ||
-                  (ioarena.conf.continuous_completing &&
-                   ioarena.doers_done < ioarena.doers_count);) {
+  do {
     iabenchmark bench;
     for (bench = IA_SET; !rc && bench < IA_MAX; bench++) {
       if (doer->benchmask & (1l << bench))
         rc = ia_run_benchmark(doer, bench);
     }
 
-    if (++count == ioarena.conf.nrepeat)
+    if (++count == 1)
       __sync_fetch_and_add(&ioarena.doers_done, 1);
 
     if (rc || ioarena.failed)
       break;
-  }
+  } while ((ioarena.conf.continuous_completing &&
+            ioarena.doers_done < ioarena.doers_count) ||
+           (ioarena.deadline && ia_timestamp_ns() < ioarena.deadline));
 
   if (doer->ctx) {
     ioarena.driver->thread_dispose(doer->ctx);
@@ -215,6 +626,16 @@ int ia_doer_init(iadoer *doer, int nth, long benchmask, int key_space,
   doer->key_sequence = key_sequence;
   doer->gen_a = NULL;
   doer->gen_b = NULL;
+  doer->gen_miss = NULL;
+  doer->miss_acc = 0;
+  doer->gen_shared = NULL;
+  doer->shared_acc = 0;
+  doer->jitter = 2654435761u * (nth + 1);
+  doer->update_buf = NULL;
+  doer->churn_head = NULL;
+  doer->churn_tail = NULL;
+  doer->churn_inserted = 0;
+  doer->churn_due = 0;
 
   if (benchmask) {
     char line[1024], *s;
@@ -225,15 +646,58 @@ int ia_doer_init(iadoer *doer, int nth, long benchmask, int key_space,
         s += snprintf(s, line + sizeof(line) - s, "%s%s", s != line ? ", " : "",
                       ia_benchmarkof(bench));
 
-    if (ia_kvgen_init(&doer->gen_a, doer->key_space, doer->key_sequence,
+    /* the ordered writers append (or prepend) from the start of their own
+     * key-spaces, rather than from the middle of these */
+    const int ordered = ioarena.conf.key_order == IA_ORDER_ASC ||
+                        ioarena.conf.key_order == IA_ORDER_DESC;
+    const int sector =
+        (ordered && (benchmask & bench_mask_write)) ? 0 : doer->key_sequence;
+    if (ia_kvgen_init(&doer->gen_a, doer->key_space, sector,
                       ioarena.conf.vsize, 0)) {
       ia_log("doer.%d: key-value generator failed, the options are correct?",
              doer->nth);
       return -1;
     }
 
+    if (ioarena.conf.soak.duration && (benchmask & (1l << IA_SET)) &&
+        (ia_kvgen_init(&doer->churn_head, doer->key_space, sector,
+                       ioarena.conf.vsize, 0) ||
+         ia_kvgen_init(&doer->churn_tail, doer->key_space, sector, 0, 0))) {
+      ia_log("doer.%d: key-value generator failed, the options are correct?",
+             doer->nth);
+      return -1;
+    }
+
+    if ((benchmask & (1l << IA_UPDATE)) &&
+        !(doer->update_buf = calloc(1, ioarena.conf.vsize + 1))) {
+      ia_log("doer.%d: out of memory", doer->nth);
+      return -1;
+    }
+
+    if (ioarena.miss_space &&
+        (benchmask & (1l << IA_GET | 1l << IA_GETMISS)) &&
+        ia_kvgen_init(&doer->gen_miss, ioarena.miss_space, doer->key_sequence,
+                      0, 0)) {
+      ia_log("doer.%d: key-value generator failed, the options are correct?",
+             doer->nth);
+      return -1;
+    }
+
+    if (ioarena.shared_space &&
+        (benchmask & (1l << IA_SET | 1l << IA_UPDATE))) {
+      if (ia_kvgen_init(&doer->gen_shared, ioarena.shared_space,
+                        doer->key_sequence, ioarena.conf.vsize, 0)) {
+        ia_log("doer.%d: key-value generator failed, the options are correct?",
+               doer->nth);
+        return -1;
+      }
+      ia_kvgen_narrow(doer->gen_shared, ioarena.conf.shared_keys
+                                            ? ioarena.conf.shared_keys
+                                            : ioarena.conf.count);
+    }
+
     if (benchmask & bench_mask_2keyspace) {
-      if (ia_kvgen_init(&doer->gen_b, doer->key_space + 1, doer->key_sequence,
+      if (ia_kvgen_init(&doer->gen_b, doer->key_space + 1, sector,
                         ioarena.conf.vsize, 0)) {
         ia_log("doer.%d: key-value generator failed, the options are correct?",
                doer->nth);
@@ -257,4 +721,10 @@ void ia_doer_destroy(iadoer *doer) {
   ia_histogram_destroy(&doer->hg);
   ia_kvgen_destroy(&doer->gen_a);
   ia_kvgen_destroy(&doer->gen_b);
+  ia_kvgen_destroy(&doer->gen_miss);
+  ia_kvgen_destroy(&doer->gen_shared);
+  free(doer->update_buf);
+  doer->update_buf = NULL;
+  ia_kvgen_destroy(&doer->churn_head);
+  ia_kvgen_destroy(&doer->churn_tail);
 }
@@ -25,6 +25,18 @@ struct iadoer {
   iacontext *ctx;
   struct ia_kvgen *gen_a;
   struct ia_kvgen *gen_b;
+  struct ia_kvgen *gen_miss;
+  int miss_acc;
+  /* the contention: the hot keys are common for all writers */
+  struct ia_kvgen *gen_shared;
+  int shared_acc;
+  uint32_t jitter;
+  char *update_buf;
+  /* the soak's churn: inserts by the head, deletes the oldest by the tail */
+  struct ia_kvgen *churn_head;
+  struct ia_kvgen *churn_tail;
+  uintmax_t churn_inserted;
+  ia_timestamp_t churn_due;
   iahistogram hg;
 };
 
@@ -32,5 +44,7 @@ int ia_doer_init(iadoer *doer, int nth, long benchmask, int key_space,
                  int key_sequence);
 int ia_doer_fulfil(iadoer *doer);
 void ia_doer_destroy(iadoer *doer);
+double ia_scan_skew(uintmax_t *min, double *avg, uintmax_t *max);
+void ia_scan_print(void);
 
 #endif
@@ -0,0 +1,720 @@
+
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ *
+ * ioarena-compare: compares two or more result sets produced by ioarena
+ * (JSON reports by `-J` or per-benchmark CSV files by `-C`) and detects
+ * statistically significant regressions against the first (baseline) set.
+ */
+
+#define _GNU_SOURCE 1
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#define IA_COMPARE_MAX_SETS 32
+
+enum { EXIT_REGRESSION = 1, EXIT_TROUBLE = 2 };
+
+/*****************************************************************************/
+
+/* a trivial JSON parser, enough to load the ioarena report. */
+typedef enum { J_NULL, J_BOOL, J_NUMBER, J_STRING, J_ARRAY, J_OBJECT } jtype;
+
+typedef struct jnode jnode;
+struct jnode {
+  jtype type;
+  char *key;
+  char *str;
+  double num;
+  jnode *child, *next;
+};
+
+typedef struct {
+  const char *text, *pos;
+  const char *filename;
+} jparser;
+
+static void json_free(jnode *node) {
+  while (node) {
+    jnode *next = node->next;
+    json_free(node->child);
+    free(node->key);
+    free(node->str);
+    free(node);
+    node = next;
+  }
+}
+
+static void json_skip(jparser *p) {
+  while (isspace((unsigned char)*p->pos))
+    p->pos++;
+}
+
+static void json_error(jparser *p, const char *what) {
+  int line = 1;
+  for (const char *s = p->text; s < p->pos; ++s)
+    line += *s == '\n';
+  fprintf(stderr, "error: %s:%d: %s\n", p->filename, line, what);
+}
+
+static char *json_parse_string(jparser *p) {
+  if (*p->pos != '"') {
+    json_error(p, "string expected");
+    return NULL;
+  }
+  const char *begin = ++p->pos;
+  while (*p->pos && *p->pos != '"')
+    p->pos += (*p->pos == '\\' && p->pos[1]) ? 2 : 1;
+  if (*p->pos != '"') {
+    json_error(p, "unterminated string");
+    return NULL;
+  }
+
+  char *str = malloc(p->pos - begin + 1), *d = str;
+  if (!str)
+    return NULL;
+  for (const char *s = begin; s < p->pos; ++s) {
+    if (*s != '\\') {
+      *d++ = *s;
+      continue;
+    }
+    switch (*++s) {
+    case 'b':
+      *d++ = '\b';
+      break;
+    case 'f':
+      *d++ = '\f';
+      break;
+    case 'n':
+      *d++ = '\n';
+      break;
+    case 'r':
+      *d++ = '\r';
+      break;
+    case 't':
+      *d++ = '\t';
+      break;
+    case 'u': {
+      /* only the ASCII subset is expected, others are replaced. */
+      unsigned code = 0;
+      int i;
+      for (i = 1; i <= 4 && isxdigit((unsigned char)s[i]); ++i)
+        code = code * 16 + (isdigit((unsigned char)s[i])
+                                ? s[i] - '0'
+                                : tolower((unsigned char)s[i]) - 'a' + 10);
+      s += i - 1;
+      *d++ = (code < 0x80) ? (char)code : '?';
+      break;
+    }
+    default:
+      *d++ = *s;
+    }
+  }
+  *d = '\0';
+  p->pos++;
+  return str;
+}
+
+static jnode *json_parse_value(jparser *p, int depth) {
+  json_skip(p);
+  if (depth > 64) {
+    json_error(p, "too deep nesting");
+    return NULL;
+  }
+
+  jnode *node = calloc(1, sizeof(jnode));
+  if (!node)
+    return NULL;
+
+  const char c = *p->pos;
+  if (c == '{' || c == '[') {
+    node->type = (c == '{') ? J_OBJECT : J_ARRAY;
+    const char close = (c == '{') ? '}' : ']';
+    jnode **tail = &node->child;
+    p->pos++;
+    json_skip(p);
+    if (*p->pos == close) {
+      p->pos++;
+      return node;
+    }
+    for (;;) {
+      char *key = NULL;
+      if (node->type == J_OBJECT) {
+        json_skip(p);
+        key = json_parse_string(p);
+        if (!key)
+          goto bailout;
+        json_skip(p);
+        if (*p->pos != ':') {
+          free(key);
+          json_error(p, "colon expected");
+          goto bailout;
+        }
+        p->pos++;
+      }
+      *tail = json_parse_value(p, depth + 1);
+      if (!*tail) {
+        free(key);
+        goto bailout;
+      }
+      (*tail)->key = key;
+      tail = &(*tail)->next;
+
+      json_skip(p);
+      if (*p->pos == ',') {
+        p->pos++;
+        continue;
+      }
+      if (*p->pos == close) {
+        p->pos++;
+        return node;
+      }
+      json_error(p, "comma or closing bracket expected");
+      goto bailout;
+    }
+  }
+
+  if (c == '"') {
+    node->type = J_STRING;
+    node->str = json_parse_string(p);
+    if (!node->str)
+      goto bailout;
+    return node;
+  }
+
+  if (strncmp(p->pos, "null", 4) == 0) {
+    node->type = J_NULL;
+    p->pos += 4;
+    return node;
+  }
+  if (strncmp(p->pos, "true", 4) == 0) {
+    node->type = J_BOOL;
+    node->num = 1;
+    p->pos += 4;
+    return node;
+  }
+  if (strncmp(p->pos, "false", 5) == 0) {
+    node->type = J_BOOL;
+    p->pos += 5;
+    return node;
+  }
+
+  char *end;
+  node->type = J_NUMBER;
+  node->num = strtod(p->pos, &end);
+  if (end == p->pos) {
+    json_error(p, "unexpected character");
+    goto bailout;
+  }
+  p->pos = end;
+  return node;
+
+bailout:
+  json_free(node);
+  return NULL;
+}
+
+static const jnode *json_get(const jnode *node, const char *key) {
+  if (!node || node->type != J_OBJECT)
+    return NULL;
+  for (node = node->child; node; node = node->next)
+    if (strcmp(node->key, key) == 0)
+      return node;
+  return NULL;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+  const char *name;
+  const char *path; /* inside of a benchmark's object of the json report */
+  int higher_is_better;
+  int latency;
+} iametric;
+
+static const iametric metrics[] = {
+    {"rps", "rps", 1, 0},
+    {"ops_rate", "ops_rate", 1, 0},
+    {"avg", "avg", 0, 1},
+    {"p50", "p50", 0, 1},
+    {"p90", "p90", 0, 1},
+    {"p99", "p99", 0, 1},
+    {"p99.9", "p99.9", 0, 1},
+    {"max", "max", 0, 1},
+};
+
+#define IA_METRICS_COUNT ((int)(sizeof(metrics) / sizeof(metrics[0])))
+
+typedef struct {
+  double *v;
+  int n, allocated;
+} iaseries;
+
+typedef struct {
+  char round[32];
+  char bench[16];
+  int metric;
+  iaseries sets[IA_COMPARE_MAX_SETS];
+} iaentry;
+
+static struct {
+  iaentry *entries;
+  int count, allocated;
+  int nsets;
+  int metric_mask;
+  double threshold;
+  double confidence;
+  int resamples;
+  uint64_t seed;
+} compare;
+
+static int ia_series_add(iaseries *s, double value) {
+  if (s->n == s->allocated) {
+    int allocated = s->allocated * 2 + 8;
+    double *v = realloc(s->v, allocated * sizeof(double));
+    if (!v)
+      return -1;
+    s->v = v;
+    s->allocated = allocated;
+  }
+  s->v[s->n++] = value;
+  return 0;
+}
+
+static int ia_compare_add(int set, const char *round, const char *bench,
+                          int metric, double value) {
+  if (!(compare.metric_mask & (1 << metric)) || !isfinite(value))
+    return 0;
+
+  iaentry *e;
+  for (e = compare.entries; e < compare.entries + compare.count; ++e)
+    if (e->metric == metric && strcmp(e->round, round) == 0 &&
+        strcmp(e->bench, bench) == 0)
+      return ia_series_add(&e->sets[set], value);
+
+  if (compare.count == compare.allocated) {
+    int allocated = compare.allocated * 2 + 16;
+    e = realloc(compare.entries, allocated * sizeof(iaentry));
+    if (!e)
+      return -1;
+    compare.entries = e;
+    compare.allocated = allocated;
+  }
+
+  e = &compare.entries[compare.count++];
+  memset(e, 0, sizeof(*e));
+  snprintf(e->round, sizeof(e->round), "%s", round);
+  snprintf(e->bench, sizeof(e->bench), "%s", bench);
+  e->metric = metric;
+  return ia_series_add(&e->sets[set], value);
+}
+
+static char *ia_load_file(const char *filename) {
+  FILE *f = fopen(filename, "r");
+  if (!f) {
+    fprintf(stderr, "error: %s: %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  size_t length = 0, allocated = 65536;
+  char *text = malloc(allocated);
+  while (text) {
+    length += fread(text + length, 1, allocated - length - 1, f);
+    if (length < allocated - 1)
+      break;
+    allocated *= 2;
+    char *tmp = realloc(text, allocated);
+    if (!tmp)
+      free(text);
+    text = tmp;
+  }
+  if (text)
+    text[length] = '\0';
+  if (ferror(f)) {
+    fprintf(stderr, "error: %s: %s\n", filename, strerror(errno));
+    free(text);
+    text = NULL;
+  }
+  fclose(f);
+  return text;
+}
+
+static int ia_load_json(int set, const char *filename) {
+  char *text = ia_load_file(filename);
+  if (!text)
+    return -1;
+
+  jparser parser = {text, text, filename};
+  jnode *root = json_parse_value(&parser, 0);
+  free(text);
+  if (!root)
+    return -1;
+
+  int rc = 0;
+  const jnode *rounds = json_get(root, "rounds");
+  if (!rounds || rounds->type != J_ARRAY) {
+    fprintf(stderr, "error: %s: not an ioarena report\n", filename);
+    rc = -1;
+  } else {
+    for (const jnode *r = rounds->child; !rc && r; r = r->next) {
+      char round[32] = "-";
+      const jnode *sweep = json_get(r, "sweep");
+      const jnode *var = json_get(sweep, "var");
+      const jnode *point = json_get(sweep, "point");
+      if (var && var->type == J_STRING && point && point->type == J_NUMBER)
+        snprintf(round, sizeof(round), "%s%.0f", var->str, point->num);
+
+      const jnode *benchmarks = json_get(r, "benchmarks");
+      for (const jnode *b = benchmarks ? benchmarks->child : NULL; !rc && b;
+           b = b->next) {
+        for (int m = 0; !rc && m < IA_METRICS_COUNT; ++m) {
+          const jnode *v =
+              json_get(metrics[m].latency ? json_get(b, "latency_ns") : b,
+                       metrics[m].path);
+          if (v && v->type == J_NUMBER)
+            rc = ia_compare_add(set, round, b->key, m, v->num);
+        }
+      }
+    }
+  }
+
+  json_free(root);
+  return rc;
+}
+
+/* the per-benchmark csv, i.e. the histogram in seconds followed by
+ * the summary line with latencies and throughput. */
+static int ia_load_csv(int set, const char *filename) {
+  const char *base = strrchr(filename, '/');
+  base = base ? base + 1 : filename;
+  const char *under = strrchr(base, '_');
+  const char *dot = strrchr(base, '.');
+  char bench[16];
+  snprintf(bench, sizeof(bench), "%.*s",
+           (int)(dot - (under ? under + 1 : base)), under ? under + 1 : base);
+
+  FILE *f = fopen(filename, "r");
+  if (!f) {
+    fprintf(stderr, "error: %s: %s\n", filename, strerror(errno));
+    return -1;
+  }
+
+  char line[1024];
+  if (!fgets(line, sizeof(line), f) || strncmp(line, "ltn_open", 8) != 0) {
+    fprintf(stderr, "error: %s: not a benchmark's csv\n", filename);
+    fclose(f);
+    return -1;
+  }
+
+  struct {
+    double from, to, count;
+  } buckets[256];
+  int nbuckets = 0;
+  double total = 0, summary[5];
+  int have_summary = 0;
+
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '\n')
+      continue;
+    if (strncmp(line, "ltn_min", 7) == 0) {
+      have_summary =
+          fgets(line, sizeof(line), f) &&
+          sscanf(line, "%lf,%lf%lf%lf,%lf", &summary[0], &summary[1],
+                 &summary[2], &summary[3], &summary[4]) == 5;
+      break;
+    }
+    if (nbuckets < 256 &&
+        sscanf(line, "%lf,%lf,%lf", &buckets[nbuckets].from,
+               &buckets[nbuckets].to, &buckets[nbuckets].count) == 3) {
+      total += buckets[nbuckets].count;
+      nbuckets += 1;
+    }
+  }
+  fclose(f);
+
+  if (!have_summary || total == 0) {
+    fprintf(stderr, "error: %s: truncated csv\n", filename);
+    return -1;
+  }
+
+  const double S = 1e9;
+  int rc = 0;
+  for (int m = 0; !rc && m < IA_METRICS_COUNT; ++m) {
+    double value = NAN;
+    if (strcmp(metrics[m].name, "rps") == 0)
+      value = summary[4];
+    else if (strcmp(metrics[m].name, "avg") == 0)
+      value = summary[1] * S;
+    else if (strcmp(metrics[m].name, "max") == 0)
+      value = summary[3] * S;
+    else if (metrics[m].name[0] == 'p') {
+      const double target = total * atof(metrics[m].name + 1) / 1e2;
+      double n = 0;
+      for (int i = 0; i < nbuckets; ++i) {
+        if (n + buckets[i].count >= target) {
+          const double part = (target - n) / buckets[i].count;
+          value = (buckets[i].from + (buckets[i].to - buckets[i].from) * part);
+          value = fmin(fmax(value, summary[0]), summary[3]) * S;
+          break;
+        }
+        n += buckets[i].count;
+      }
+    }
+    rc = ia_compare_add(set, "-", bench, m, value);
+  }
+  return rc;
+}
+
+static int ia_load_set(int set, const char *list) {
+  char *names = strdup(list);
+  if (!names)
+    return -1;
+
+  int rc = 0;
+  char *save = NULL;
+  for (char *name = strtok_r(names, ",", &save); !rc && name;
+       name = strtok_r(NULL, ",", &save)) {
+    const size_t len = strlen(name);
+    if (len > 4 && strcasecmp(name + len - 4, ".csv") == 0)
+      rc = ia_load_csv(set, name);
+    else
+      rc = ia_load_json(set, name);
+  }
+  free(names);
+  return rc;
+}
+
+/*****************************************************************************/
+
+static uint64_t ia_random(void) {
+  /* xorshift64* */
+  compare.seed ^= compare.seed >> 12;
+  compare.seed ^= compare.seed << 25;
+  compare.seed ^= compare.seed >> 27;
+  return compare.seed * UINT64_C(2685821657736338717);
+}
+
+static double ia_mean(const double *v, int n) {
+  double sum = 0;
+  for (int i = 0; i < n; ++i)
+    sum += v[i];
+  return sum / n;
+}
+
+static double ia_resample_mean(const iaseries *s) {
+  double sum = 0;
+  for (int i = 0; i < s->n; ++i)
+    sum += s->v[ia_random() % s->n];
+  return sum / s->n;
+}
+
+static int ia_cmp_double(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/* the percentile bootstrap of the relative difference of the means,
+ * i.e. of (candidate / baseline - 1). */
+static int ia_bootstrap(const iaseries *base, const iaseries *cand,
+                        double *lo, double *hi) {
+  double *deltas = malloc(compare.resamples * sizeof(double));
+  if (!deltas)
+    return -1;
+
+  for (int i = 0; i < compare.resamples; ++i)
+    deltas[i] = ia_resample_mean(cand) / ia_resample_mean(base) - 1;
+  qsort(deltas, compare.resamples, sizeof(double), ia_cmp_double);
+
+  const double alpha = (1 - compare.confidence) / 2;
+  *lo = deltas[(int)floor(alpha * (compare.resamples - 1))];
+  *hi = deltas[(int)ceil((1 - alpha) * (compare.resamples - 1))];
+  free(deltas);
+  return 0;
+}
+
+static void ia_snpf_metric(char *buf, size_t size, double value, int latency) {
+  static const char *units_lat[] = {"ns", "us", "ms", "s"};
+  static const char *units_val[] = {"", "K", "M", "G"};
+  int i = 0;
+  while (i < 3 && value >= 1e3) {
+    value /= 1e3;
+    i += 1;
+  }
+  snprintf(buf, size, "%.3f%s", value, latency ? units_lat[i] : units_val[i]);
+}
+
+static int ia_compare_report(const char *const *names) {
+  int regressions = 0;
+
+  for (int set = 1; set < compare.nsets; ++set) {
+    char title[32];
+    snprintf(title, sizeof(title), "%g%% ci", compare.confidence * 1e2);
+    printf("\n>>> %s\n vs %s\n", names[set], names[0]);
+    printf("%-12s %-8s %-6s %10s %10s %8s  %-20s  %s\n", "round", "bench",
+           "metric", "baseline", "candidate", "delta", title, "verdict");
+
+    for (const iaentry *e = compare.entries;
+         e < compare.entries + compare.count; ++e) {
+      const iaseries *base = &e->sets[0], *cand = &e->sets[set];
+      if (!base->n || !cand->n)
+        continue;
+
+      const iametric *m = &metrics[e->metric];
+      const double mb = ia_mean(base->v, base->n);
+      const double mc = ia_mean(cand->v, cand->n);
+      const double delta = mc / mb - 1;
+
+      char vb[32], vc[32], ci[32];
+      ia_snpf_metric(vb, sizeof(vb), mb, m->latency);
+      ia_snpf_metric(vc, sizeof(vc), mc, m->latency);
+
+      const char *verdict;
+      if (base->n < 2 || cand->n < 2) {
+        snprintf(ci, sizeof(ci), "n/a");
+        verdict = "(need repeats)";
+      } else {
+        double lo, hi;
+        if (ia_bootstrap(base, cand, &lo, &hi))
+          return -1;
+        snprintf(ci, sizeof(ci), "[%+.1f%%, %+.1f%%]", lo * 1e2, hi * 1e2);
+
+        /* the worse is a lower throughput or a higher latency */
+        const double worst = m->higher_is_better ? -hi : lo;
+        const double best = m->higher_is_better ? -lo : hi;
+        if (worst > compare.threshold) {
+          verdict = "REGRESSION";
+          regressions += 1;
+        } else if (best < -compare.threshold)
+          verdict = "improvement";
+        else
+          verdict = "~";
+      }
+
+      printf("%-12s %-8s %-6s %10s %10s %+7.1f%%  %-20s  %s\n", e->round,
+             e->bench, m->name, vb, vc, delta * 1e2, ci, verdict);
+    }
+  }
+
+  printf("\n%d regression(s) detected.\n", regressions);
+  return regressions;
+}
+
+/*****************************************************************************/
+
+static void ia_compare_usage(void) {
+  printf("usage: ioarena-compare [hmtcbs] <baseline> <candidate>...\n");
+  printf("  each of result set is a JSON report (by `ioarena -J`) or a\n");
+  printf("  per-benchmark CSV (by `ioarena -C`), or a comma separated list\n");
+  printf("  of such files to merge repeated runs into the one set.\n");
+  printf("  -m <metrics>          (default: rps, p50, p99)\n");
+  printf("     choices:");
+  for (int m = 0; m < IA_METRICS_COUNT; ++m)
+    printf("%s %s", m ? "," : "", metrics[m].name);
+  printf("\n");
+  printf("  -t <percents> regression threshold  (default: %g)\n",
+         compare.threshold * 1e2);
+  printf("  -c <percents> confidence level      (default: %g)\n",
+         compare.confidence * 1e2);
+  printf("  -b <number_of_bootstrap_resamples>  (default: %d)\n",
+         compare.resamples);
+  printf("  -s <seed>                           (default: %ju)\n",
+         (uintmax_t)compare.seed);
+  printf("  -h                                  help\n");
+  printf("\nexit status: 0 - no regression, %d - regression(s) detected, %d - "
+         "trouble.\n",
+         EXIT_REGRESSION, EXIT_TROUBLE);
+  printf("\nexample:\n");
+  printf("   ioarena-compare -m p99 last.json today-1.json,today-2.json\n");
+}
+
+static int ia_parse_metrics(const char *list) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s", list);
+  compare.metric_mask = 0;
+  for (char *p = strtok(buf, ", "); p; p = strtok(NULL, ", ")) {
+    int m;
+    for (m = 0; m < IA_METRICS_COUNT; ++m)
+      if (strcasecmp(p, metrics[m].name) == 0)
+        break;
+    if (m == IA_METRICS_COUNT) {
+      fprintf(stderr, "error: unknown metric '%s'\n", p);
+      return -1;
+    }
+    compare.metric_mask |= 1 << m;
+  }
+  return compare.metric_mask ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+  compare.threshold = 0;
+  compare.confidence = 0.95;
+  compare.resamples = 10000;
+  compare.seed = 42;
+  ia_parse_metrics("rps, p50, p99");
+
+  int opt;
+  while ((opt = getopt(argc, argv, "hm:t:c:b:s:")) != -1) {
+    switch (opt) {
+    case 'm':
+      if (ia_parse_metrics(optarg))
+        return EXIT_TROUBLE;
+      break;
+    case 't':
+      compare.threshold = atof(optarg) / 1e2;
+      break;
+    case 'c':
+      compare.confidence = atof(optarg) / 1e2;
+      if (compare.confidence <= 0 || compare.confidence >= 1) {
+        fprintf(stderr, "error: bad confidence level '%s'\n", optarg);
+        return EXIT_TROUBLE;
+      }
+      break;
+    case 'b':
+      compare.resamples = atoi(optarg);
+      if (compare.resamples < 100) {
+        fprintf(stderr, "error: too few bootstrap resamples '%s'\n", optarg);
+        return EXIT_TROUBLE;
+      }
+      break;
+    case 's':
+      compare.seed = strtoull(optarg, NULL, 0);
+      if (!compare.seed)
+        compare.seed = 42;
+      break;
+    case 'h':
+      ia_compare_usage();
+      return EXIT_SUCCESS;
+    default:
+      ia_compare_usage();
+      return EXIT_TROUBLE;
+    }
+  }
+
+  compare.nsets = argc - optind;
+  if (compare.nsets < 2 || compare.nsets > IA_COMPARE_MAX_SETS) {
+    ia_compare_usage();
+    return EXIT_TROUBLE;
+  }
+
+  const char *const *names = (const char *const *)argv + optind;
+  for (int set = 0; set < compare.nsets; ++set)
+    if (ia_load_set(set, names[set]))
+      return EXIT_TROUBLE;
+
+  const int rc = ia_compare_report(names);
+  if (rc < 0)
+    return EXIT_TROUBLE;
+  return rc ? EXIT_REGRESSION : EXIT_SUCCESS;
+}
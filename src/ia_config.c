@@ -19,9 +19,22 @@ int ia_configinit(iaconfig *c) {
   c->ksize = 16;
   c->vsize = 32;
   c->csv_prefix = NULL;
+  c->json_path = NULL;
   c->rthr = 0;
   c->wthr = 0;
   c->batch_length = 500;
+  c->txn_length = 1;
+  c->get_length = 1;
+  c->get_budget_ms = 0;
+  c->miss_ratio = 0;
+  c->shared_ratio = 0;
+  c->shared_keys = 0;
+  c->pin_ms = 0;
+  c->scan_partitions = 0;
+  c->sweep.var = IA_SWEEP_NONE;
+  c->sweep.npoints = 0;
+  c->soak.duration = 0;
+  c->soak.rate = 0;
   c->benchmark = strdup("set, get");
   if (c->benchmark == NULL) {
     free(c->path);
@@ -35,6 +48,11 @@ int ia_configinit(iaconfig *c) {
   }
   c->syncmode = IA_LAZY;
   c->walmode = IA_WAL_INDEF;
+  c->key_order = IA_ORDER_RANDOM;
+  c->key_window = 0;
+  c->key_format = IA_KEY_RANDOM;
+  c->key_tenants = c->key_tables = 1;
+  c->value_ratio = 0;
   c->continuous_completing = 0;
   c->nrepeat = 1;
 
@@ -42,6 +60,7 @@ int ia_configinit(iaconfig *c) {
   c->binary = 0;
   c->separate = 0;
   c->ignore_keynotfound = 0;
+  c->reserve = 0;
   return 0;
 }
 
@@ -81,6 +100,62 @@ const char *ia_walmode2str(iawalmode walmode) {
   }
 }
 
+const char *ia_keyorder2str(iakeyorder order) {
+  switch (order) {
+  case IA_ORDER_RANDOM:
+    return "random";
+  case IA_ORDER_ASC:
+    return "asc";
+  case IA_ORDER_DESC:
+    return "desc";
+  case IA_ORDER_BATCH:
+    return "batch";
+  default:
+    return "???";
+  }
+}
+
+const char *ia_keyformat2str(iakeyformat format) {
+  switch (format) {
+  case IA_KEY_RANDOM:
+    return "random";
+  case IA_KEY_INT:
+    return "int";
+  case IA_KEY_PREFIX:
+    return "prefix";
+  default:
+    return "???";
+  }
+}
+
+int ia_key_window(const iaconfig *c) {
+  if (c->key_window)
+    return c->key_window;
+  return (c->txn_length > 1) ? c->txn_length : c->batch_length;
+}
+
+static iakeyorder ia_str2keyorder(const char *str) {
+  if (strcasecmp(str, ia_keyorder2str(IA_ORDER_RANDOM)) == 0)
+    return IA_ORDER_RANDOM;
+  if (strcasecmp(str, ia_keyorder2str(IA_ORDER_ASC)) == 0)
+    return IA_ORDER_ASC;
+  if (strcasecmp(str, ia_keyorder2str(IA_ORDER_DESC)) == 0)
+    return IA_ORDER_DESC;
+  if (strcasecmp(str, ia_keyorder2str(IA_ORDER_BATCH)) == 0)
+    return IA_ORDER_BATCH;
+  return -1;
+}
+
+static iakeyformat ia_str2keyformat(const char *str) {
+  if (strcasecmp(str, ia_keyformat2str(IA_KEY_RANDOM)) == 0)
+    return IA_KEY_RANDOM;
+  if (strcasecmp(str, ia_keyformat2str(IA_KEY_INT)) == 0)
+    return IA_KEY_INT;
+  if (strcasecmp(str, ia_keyformat2str(IA_KEY_PREFIX)) == 0)
+    return IA_KEY_PREFIX;
+  return -1;
+}
+
 static iawalmode ia_str2walmode(const char *str) {
   if (strcasecmp(str, ia_walmode2str(IA_WAL_INDEF)) == 0)
     return IA_WAL_INDEF;
@@ -92,27 +167,38 @@ static iawalmode ia_str2walmode(const char *str) {
 }
 
 static inline void ia_configusage(iaconfig *c) {
-  ia_log("usage: ioarena [hDBCpnkvmlrwic]");
+  ia_log("usage: ioarena [hDBCJpnkvzmlOFrwictgMXHISRKsZ]");
   ia_log("  -D <database_driver>");
   ia_log("     choices: %s", ia_supported());
   ia_log("  -B <benchmarks>");
-  ia_log("     choices: set, get, delete, iterate, batch, crud");
+  ia_log("     choices: set, get, get-miss, update, delete, iterate, batch, "
+         "crud");
   ia_log("  -m <sync_mode>                     (default: %s)",
          ia_syncmode2str(c->syncmode));
   ia_log("     choices: sync, lazy, nosync");
   ia_log("  -l <wal_mode>                      (default: %s)",
          ia_walmode2str(c->walmode));
   ia_log("     choices: indef, walon, waloff");
+  ia_log("  -O <key_order>[:<window>]          (default: %s)",
+         ia_keyorder2str(c->key_order));
+  ia_log("     choices: random, asc, desc, batch (sorted by txn or window)");
+  ia_log("  -F <key_format>                    (default: %s)",
+         ia_keyformat2str(c->key_format));
+  ia_log("     choices: random, int (big-endian),");
+  ia_log("              prefix[:<tenants>[:<tables>]] (default 16:16)");
   if (c->driver_if) {
     if (c->driver_if->option)
       c->driver_if->option(NULL, "--help");
   } else
     ia_log("  -o <database_option>");
   ia_log("  -C <name-prefix> generate csv      (default: %s)", c->csv_prefix);
+  ia_log("  -J <filename> write json report    (default: %s)", c->json_path);
   ia_log("  -p <path> for temporaries          (default: %s)", c->path);
   ia_log("  -n <number_of_operations>          (default: %ju)", c->count);
   ia_log("  -k <key_size>                      (default: %d)", c->ksize);
   ia_log("  -v <value_size>                    (default: %d)", c->vsize);
+  ia_log("  -z <compression_ratio>[:1]         (default: none)");
+  ia_log("     values are compressible about N:1, `1` for incompressible");
   ia_log("  -c continuous completing mode      (default: %s)",
          c->continuous_completing ? "yes" : "no");
   ia_log("  -r <number_of_read_threads>        (default: %d)", c->rthr);
@@ -121,6 +207,33 @@ static inline void ia_configusage(iaconfig *c) {
   ia_log("     `zero` to use single main/common thread");
   ia_log("  -i ignore key-not-found error      (default: %s)",
          c->ignore_keynotfound ? "yes" : "no");
+  ia_log("  -Z reserve-write (zero-copy) mode  (default: %s)",
+         c->reserve ? "yes" : "no");
+  ia_log("     values are rendered in-place into the space reserved by "
+         "the engine");
+  ia_log("  -t <set/delete_ops_per_txn>        (default: %d)", c->txn_length);
+  ia_log("  -g <get_ops_per_txn>[ms]           (default: %d)", c->get_length);
+  ia_log("     `Nms` to hold each read txn for N milliseconds");
+  ia_log("  -M <percent_of_get_misses>         (default: %d)", c->miss_ratio);
+  ia_log("     keys are drawn from a key-space which is never written");
+  ia_log("  -X <percent>[:<hot_keys>]          (default: none)");
+  ia_log("     share of writes to the <hot_keys> common for all writers");
+  ia_log("     (default <number_of_operations>), conflicts are retried");
+  ia_log("  -H <seconds>[ms] | round           (default: none)");
+  ia_log("     a reader holds a snapshot while the others proceed");
+  ia_log("  -I <number_of_scan_partitions>     (default: none)");
+  ia_log("     the iterate readers share the key ranges instead of full scans");
+  ia_log("  -S <sweep>=<list>                  (default: none)");
+  ia_log("     choices: txn (default 1..4096),");
+  ia_log("              r, w, rw (threads, default 1..<number_of_cpu>)");
+  ia_log("     list of N, N..M (doubling) or N..M+K (step K)");
+  ia_log("  -R <number_of_repeats>             (default: %d)", c->nrepeat);
+  ia_log("  -K <number_of_crashes>             (default: %d)", c->crashes);
+  ia_log("     crash-recovery test, the set is killed at random points");
+  ia_log("  -s <duration>[s|m|h][:<rate>]      (default: none)");
+  ia_log("     soak for the duration, with the churn of the <number_of_"
+         "operations>");
+  ia_log("     live keys at the given rate of inserts+deletes per second");
   ia_log("  -h                                 help");
 
   ia_log("\nexample:");
@@ -130,7 +243,9 @@ static inline void ia_configusage(iaconfig *c) {
 int ia_configparse(iaconfig *c, int argc, char **argv) {
   int opt;
   struct iaoption **drv_opt /* the tail of single-linked list */ = &c->drv_opts;
-  while ((opt = getopt(argc, argv, "hD:T:B:p:n:k:v:C:m:l:r:w:ico:")) != -1) {
+  while ((opt = getopt(argc, argv,
+                       "hD:T:B:p:n:k:v:z:C:J:m:l:O:F:r:w:icZo:t:g:"
+                       "M:X:H:I:S:R:s:K:")) != -1) {
     switch (opt) {
     case 'D':
       if (c->driver)
@@ -180,6 +295,9 @@ int ia_configparse(iaconfig *c, int argc, char **argv) {
     case 'C':
       c->csv_prefix = optarg;
       break;
+    case 'J':
+      c->json_path = optarg;
+      break;
     case 'm':
       c->syncmode = ia_str2syncmode(optarg);
       if (c->syncmode == (iasyncmode)-1) {
@@ -194,6 +312,67 @@ int ia_configparse(iaconfig *c, int argc, char **argv) {
         return -1;
       }
       break;
+    case 'z': {
+      char *end = NULL;
+      c->value_ratio = strtod(optarg, &end);
+      if (end && strcmp(end, ":1") == 0)
+        end += 2;
+      if (end == optarg || *end || !(c->value_ratio >= 1) ||
+          c->value_ratio > 1e6) {
+        ia_log("error: bad compression ratio '%s'", optarg);
+        return -1;
+      }
+      break;
+    }
+    case 'O': {
+      char name[16], *end = NULL;
+      const char *colon = strchr(optarg, ':');
+      const size_t len = colon ? (size_t)(colon - optarg) : strlen(optarg);
+      long window = 0;
+      if (colon)
+        window = strtol(colon + 1, &end, 10);
+      if (len >= sizeof(name) || (colon && (window < 1 || *end))) {
+        ia_log("error: bad key order '%s'", optarg);
+        return -1;
+      }
+      memcpy(name, optarg, len);
+      name[len] = 0;
+      c->key_order = ia_str2keyorder(name);
+      if (c->key_order == (iakeyorder)-1 ||
+          (colon && c->key_order != IA_ORDER_BATCH) || window > INT_MAX) {
+        ia_log("error: unknown key order '%s'", optarg);
+        return -1;
+      }
+      c->key_window = (int)window;
+      break;
+    }
+    case 'F': {
+      char name[16], *end = NULL;
+      const char *colon = strchr(optarg, ':');
+      const size_t len = colon ? (size_t)(colon - optarg) : strlen(optarg);
+      unsigned long tenants = 16, tables = 16;
+      if (colon) {
+        tenants = strtoul(colon + 1, &end, 10);
+        if (*end == ':')
+          tables = strtoul(end + 1, &end, 10);
+      }
+      if (len >= sizeof(name) || (colon && *end) || tenants < 1 ||
+          tables < 1 || tenants > UINT16_MAX || tables > UINT16_MAX) {
+        ia_log("error: bad key format '%s'", optarg);
+        return -1;
+      }
+      memcpy(name, optarg, len);
+      name[len] = 0;
+      c->key_format = ia_str2keyformat(name);
+      if (c->key_format == (iakeyformat)-1 ||
+          (colon && c->key_format != IA_KEY_PREFIX)) {
+        ia_log("error: unknown key format '%s'", optarg);
+        return -1;
+      }
+      c->key_tenants = (c->key_format == IA_KEY_PREFIX) ? tenants : 1;
+      c->key_tables = (c->key_format == IA_KEY_PREFIX) ? tables : 1;
+      break;
+    }
     case 'r':
       if (optarg)
         c->rthr = atoi(optarg);
@@ -212,6 +391,105 @@ int ia_configparse(iaconfig *c, int argc, char **argv) {
     case 'c':
       c->continuous_completing = 1;
       break;
+    case 'Z':
+      c->reserve = 1;
+      break;
+    case 't':
+      c->txn_length = atoi(optarg);
+      if (c->txn_length < 1) {
+        ia_log("error: bad number of operations per transaction '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'g': {
+      char *suffix;
+      const long n = strtol(optarg, &suffix, 10);
+      if (n < 1 || n > INT_MAX || (*suffix && strcmp(suffix, "ms") != 0)) {
+        ia_log("error: bad number of gets per transaction '%s'", optarg);
+        return -1;
+      }
+      c->get_length = *suffix ? 0 : (int)n;
+      c->get_budget_ms = *suffix ? (int)n : 0;
+      break;
+    }
+    case 'M': {
+      char *end;
+      const long n = strtol(optarg, &end, 10);
+      if (n < 0 || n > 100 || end == optarg || (*end && strcmp(end, "%"))) {
+        ia_log("error: bad percent of get misses '%s'", optarg);
+        return -1;
+      }
+      c->miss_ratio = (int)n;
+      break;
+    }
+    case 'H': {
+      char *suffix;
+      const long n = strtol(optarg, &suffix, 10);
+      if (strcmp(optarg, "round") == 0)
+        c->pin_ms = -1;
+      else if (n < 1 || n > INT_MAX / 1000 ||
+               (*suffix && strcmp(suffix, "ms") != 0)) {
+        ia_log("error: bad hold of the pinned reader '%s'", optarg);
+        return -1;
+      } else
+        c->pin_ms = *suffix ? (int)n : (int)n * 1000;
+      break;
+    }
+    case 'I': {
+      char *end;
+      const long n = strtol(optarg, &end, 10);
+      if (n < 1 || n > IA_SCAN_MAX || *end) {
+        ia_log("error: bad number of scan partitions '%s', up to %d", optarg,
+               IA_SCAN_MAX);
+        return -1;
+      }
+      c->scan_partitions = (int)n;
+      break;
+    }
+    case 'X': {
+      char *end;
+      const long n = strtol(optarg, &end, 10);
+      uintmax_t keys = 0;
+      if (*end == ':') {
+        const char *const from = end + 1;
+        keys = strtoumax(from, &end, 10);
+        if (end == from || keys < 1)
+          end = optarg;
+      }
+      if (n < 1 || n > 100 || end == optarg || *end) {
+        ia_log("error: bad contention '%s'", optarg);
+        return -1;
+      }
+      c->shared_ratio = (int)n;
+      c->shared_keys = keys;
+      break;
+    }
+    case 'S':
+      if (ia_sweep_parse(&c->sweep, optarg)) {
+        ia_log("error: invalid sweep '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'R':
+      c->nrepeat = atoi(optarg);
+      if (c->nrepeat < 1) {
+        ia_log("error: bad number of repeats '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 'K':
+      c->crashes = atoi(optarg);
+      if (c->crashes < 1) {
+        ia_log("error: bad number of crashes '%s'", optarg);
+        return -1;
+      }
+      break;
+    case 's':
+      if (ia_soak_parse(&c->soak, optarg)) {
+        ia_log("error: invalid soak '%s'", optarg);
+        return -1;
+      }
+      break;
     case 'h':
       ia_configusage(c);
       return 1;
@@ -224,6 +502,11 @@ int ia_configparse(iaconfig *c, int argc, char **argv) {
     ia_configusage(c);
     return -1;
   }
+  if (c->reserve && !c->driver_if->reserve) {
+    ia_log("error: database driver '%s' don't support reserve-write",
+           c->driver);
+    return -1;
+  }
   if (c->drv_opts && !c->driver_if->option) {
     ia_log("error: database driver '%s' don't support option(s)", c->driver);
     return -1;
@@ -268,18 +551,67 @@ void ia_configprint(iaconfig *c) {
   ia_log("  benchmark    = %s", c->benchmark);
   ia_log("  durability   = %s", ia_syncmode2str(c->syncmode));
   ia_log("  wal          = %s", ia_walmode2str(c->walmode));
+  if (c->key_order == IA_ORDER_BATCH && c->key_window)
+    ia_log("  key order    = %s of %d", ia_keyorder2str(c->key_order),
+           c->key_window);
+  else if (c->key_order != IA_ORDER_RANDOM)
+    ia_log("  key order    = %s", ia_keyorder2str(c->key_order));
+  if (c->key_format == IA_KEY_PREFIX)
+    ia_log("  key format   = %s of %u tenants by %u tables",
+           ia_keyformat2str(c->key_format), c->key_tenants, c->key_tables);
+  else if (c->key_format != IA_KEY_RANDOM)
+    ia_log("  key format   = %s", ia_keyformat2str(c->key_format));
   for (struct iaoption *drv_opt = c->drv_opts; drv_opt; drv_opt = drv_opt->next)
     ia_log("          option %s", drv_opt->arg);
   ia_log("  operations   = %ju", c->count);
   ia_log("  key size     = %d", c->ksize);
   ia_log("  value size   = %d", c->vsize);
+  if (c->value_ratio > 1)
+    ia_log("  compression  = %.2f:1", c->value_ratio);
   ia_log("  binary       = %s", c->binary ? "yes" : "no");
+  if (c->reserve)
+    ia_log("  reserve      = yes");
   if (c->rthr)
     ia_log("  r-threads    = %d", c->rthr);
   if (c->wthr)
     ia_log("  w-threads    = %d", c->wthr);
   if (ia_benchmark(c->benchmark) == IA_BATCH || c->benchmark_list[IA_BATCH])
     ia_log("  batch length = %d", c->batch_length);
+  if (c->txn_length > 1)
+    ia_log("  txn length   = %d", c->txn_length);
+  if (c->get_budget_ms)
+    ia_log("  get txn      = %d ms", c->get_budget_ms);
+  else if (c->get_length > 1)
+    ia_log("  get txn      = %d", c->get_length);
+  if (c->miss_ratio)
+    ia_log("  get misses   = %d%%", c->miss_ratio);
+  if (c->shared_ratio)
+    ia_log("  contention   = %d%% of %ju keys", c->shared_ratio,
+           c->shared_keys ? c->shared_keys : c->count);
+  if (c->scan_partitions)
+    ia_log("  scan parts   = %d", c->scan_partitions);
+  if (c->pin_ms < 0)
+    ia_log("  pinned read  = whole round");
+  else if (c->pin_ms)
+    ia_log("  pinned read  = %d ms", c->pin_ms);
+  if (c->sweep.var != IA_SWEEP_NONE) {
+    char line[1024], *s = line;
+    for (int i = 0; i < c->sweep.npoints; ++i)
+      s += snprintf(s, line + sizeof(line) - s, "%s%d", i ? ", " : "",
+                    c->sweep.points[i]);
+    ia_log("  sweep        = %s {%s}", ia_sweepvar2str(c->sweep.var), line);
+  }
+  if (c->nrepeat > 1)
+    ia_log("  repeats      = %d", c->nrepeat);
+  if (c->crashes)
+    ia_log("  crashes      = %d", c->crashes);
+  if (c->soak.duration) {
+    if (c->soak.rate)
+      ia_log("  soak         = %u s, churn %u/s", c->soak.duration,
+             c->soak.rate);
+    else
+      ia_log("  soak         = %u s, unlimited churn", c->soak.duration);
+  }
   ia_log("  continuous   = %s\n", c->continuous_completing ? "yes" : "no");
 }
 
@@ -289,6 +621,10 @@ const char *ia_benchmarkof(iabenchmark b) {
     return "set";
   case IA_GET:
     return "get";
+  case IA_GETMISS:
+    return "miss";
+  case IA_UPDATE:
+    return "upd";
   case IA_DELETE:
     return "del";
   case IA_ITERATE:
@@ -308,6 +644,10 @@ iabenchmark ia_benchmark(const char *name) {
     return IA_SET;
   else if (strcasecmp(name, "get") == 0)
     return IA_GET;
+  else if (strcasecmp(name, "get-miss") == 0 || strcasecmp(name, "miss") == 0)
+    return IA_GETMISS;
+  else if (strcasecmp(name, "upd") == 0 || strcasecmp(name, "update") == 0)
+    return IA_UPDATE;
   else if (strcasecmp(name, "del") == 0 || strcasecmp(name, "delete") == 0)
     return IA_DELETE;
   else if (strcasecmp(name, "iter") == 0 || strcasecmp(name, "iterate") == 0)
@@ -323,14 +663,33 @@ static int partmatch(const char *part, size_t part_len, const char *item) {
   return part_len == strlen(item) && strncasecmp(part, item, part_len) == 0;
 }
 
-int ia_parse_option_bool(const char **parg, const char *opt, int8_t *target) {
+/* returns the value of `opt=value` item, or NULL if don't match */
+static const char *option_value(const char *arg, const char *opt,
+                                size_t *value_len) {
   const size_t name_len = strlen(opt);
-  if (strncasecmp(*parg, opt, name_len) != 0 || (*parg)[name_len] != '=')
-    return 0 /* don't match */;
+  if (strncasecmp(arg, opt, name_len) != 0 || arg[name_len] != '=')
+    return NULL;
 
-  const char *const value = *parg + name_len + 1;
+  const char *const value = arg + name_len + 1;
   const char *const comma = strchr(value, ',');
-  const size_t value_len = comma ? (size_t)(comma - value) : strlen(value);
+  *value_len = comma ? (size_t)(comma - value) : strlen(value);
+  return value;
+}
+
+static int option_next(const char **parg, const char *value,
+                       size_t value_len) {
+  if (value[value_len] != ',')
+    return 1 /* done */;
+
+  *parg = value + value_len + 1 /* seek after the comma */;
+  return **parg == '\0' /* continue if not at the end */;
+}
+
+int ia_parse_option_bool(const char **parg, const char *opt, int8_t *target) {
+  size_t value_len;
+  const char *const value = option_value(*parg, opt, &value_len);
+  if (!value)
+    return 0 /* don't match */;
 
   if (partmatch(value, value_len, "ON") || partmatch(value, value_len, "YES") ||
       partmatch(value, value_len, "TRUE") || partmatch(value, value_len, "1"))
@@ -343,9 +702,60 @@ int ia_parse_option_bool(const char **parg, const char *opt, int8_t *target) {
   else
     return -1 /* invalid value */;
 
-  if (!comma)
-    return 1 /* done */;
+  return option_next(parg, value, value_len);
+}
 
-  *parg = comma + 1 /* seek after the comma */;
-  return **parg == '\0' /* continue if not at the end */;
+int ia_parse_option_size(const char **parg, const char *opt,
+                         intmax_t *target) {
+  size_t value_len;
+  const char *const value = option_value(*parg, opt, &value_len);
+  if (!value)
+    return 0 /* don't match */;
+
+  char *end;
+  errno = 0;
+  uintmax_t number = strtoumax(value, &end, 0);
+  if (end == value || errno)
+    return -1 /* invalid value */;
+
+  int shift = 0;
+  if (end < value + value_len) {
+    switch (toupper(*end++)) {
+    case 'K':
+      shift = 10;
+      break;
+    case 'M':
+      shift = 20;
+      break;
+    case 'G':
+      shift = 30;
+      break;
+    case 'T':
+      shift = 40;
+      break;
+    default:
+      return -1 /* invalid suffix */;
+    }
+  }
+  if (end != value + value_len || number > (uintmax_t)(INTMAX_MAX >> shift))
+    return -1 /* invalid value */;
+
+  *target = (intmax_t)(number << shift);
+  return option_next(parg, value, value_len);
+}
+
+int ia_parse_option_enum(const char **parg, const char *opt,
+                         const char *const choices[], int *target) {
+  size_t value_len;
+  const char *const value = option_value(*parg, opt, &value_len);
+  if (!value)
+    return 0 /* don't match */;
+
+  for (int i = 0; choices[i]; ++i)
+    if (partmatch(value, value_len, choices[i])) {
+      *target = i;
+      return option_next(parg, value, value_len);
+    }
+
+  return -1 /* invalid value */;
 }
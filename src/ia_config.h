@@ -12,6 +12,11 @@
 typedef struct iaconfig iaconfig;
 
 #include "ia_driver.h"
+#include "ia_soak.h"
+#include "ia_sweep.h"
+
+/* up to the number of 2-byte prefixes of printable keys, see ia_kv_split() */
+#define IA_SCAN_MAX 4096
 
 struct iaoption {
   const char *arg;
@@ -27,18 +32,36 @@ struct iaconfig {
   int benchmark_list[IA_MAX];
   int ksize;
   int vsize;
+  double value_ratio /* the target compression of values, zero for none */;
   uintmax_t count;
   iasyncmode syncmode;
   iawalmode walmode;
+  iakeyorder key_order;
+  int key_window /* of the sorted batches, zero for the txn length */;
+  iakeyformat key_format;
+  unsigned key_tenants, key_tables /* the cardinality of the prefixes */;
   int rthr;
   int wthr;
   int batch_length;
+  int txn_length;
+  int get_length;
+  int get_budget_ms;
+  int miss_ratio /* percent of gets to be missed */;
+  int shared_ratio /* percent of writes to the contended key space */;
+  uintmax_t shared_keys /* the number of contended keys */;
+  int scan_partitions /* of the parallel iterate, zero to scan all */;
+  int pin_ms /* hold of the pinned read snapshot, -1 for the whole round */;
   int nrepeat;
+  int crashes;
   int kvseed;
   const char *csv_prefix;
+  const char *json_path;
+  iasweep sweep;
+  iasoak soak;
   char binary;
   char separate;
   char ignore_keynotfound;
+  char reserve;
   char continuous_completing;
 };
 
@@ -49,10 +72,19 @@ void ia_configfree(iaconfig *);
 
 const char *ia_syncmode2str(iasyncmode syncmode);
 const char *ia_walmode2str(iawalmode walmode);
+const char *ia_keyorder2str(iakeyorder order);
+const char *ia_keyformat2str(iakeyformat format);
+/* the window of the sorted batches, a write transaction by default */
+int ia_key_window(const iaconfig *c);
 
 #define ia_opt_bool_default 0
 #define ia_opt_bool_off -1
 #define ia_opt_bool_on 1
 int ia_parse_option_bool(const char **parg, const char *opt, int8_t *target);
+/* a number with an optional K/M/G/T binary suffix */
+int ia_parse_option_size(const char **parg, const char *opt, intmax_t *target);
+/* one of the NULL-terminated choices, the target gets its index */
+int ia_parse_option_enum(const char **parg, const char *opt,
+                         const char *const choices[], int *target);
 
 #endif
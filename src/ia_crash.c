@@ -0,0 +1,275 @@
+﻿
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+#include "ioarena.h"
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* shared with the child processes */
+struct iacrash_shared {
+  volatile uintmax_t acked;
+  iacrash result;
+};
+
+static int ia_crash_unlink(const char *fpath, const struct stat *sb,
+                           int typeflag, struct FTW *ftwbuf) {
+  (void)sb;
+  (void)typeflag;
+  /* keep the datadir itself */
+  return ftwbuf->level ? remove(fpath) : 0;
+}
+
+/* The writer: runs the sequential set with the given txn length and
+ * publishes the number of acknowledged (i.e. committed) writes, until
+ * it will be killed. */
+static int ia_crash_writer(struct iacrash_shared *shared) {
+  iadriver *drv = ioarena.driver;
+  struct ia_kvgen *gen = NULL;
+  iacontext *ctx = NULL;
+
+  int rc = drv->open(ioarena.datadir);
+  if (rc == 0) {
+    ctx = drv->thread_new();
+    if (ctx == NULL)
+      rc = -1;
+  }
+  if (rc == 0)
+    rc = ia_kvgen_init(&gen, 0, 0, ioarena.conf.vsize, 0);
+
+  for (uintmax_t i = 0; rc == 0 && i < ioarena.conf.count;) {
+    int j = 0;
+    rc = drv->begin(ctx, IA_SET);
+    for (; rc == 0 && j < ioarena.conf.txn_length &&
+           i + j < ioarena.conf.count;
+         ++j) {
+      iakv kv;
+      rc = ia_kvgen_get(gen, &kv, 0);
+      if (rc == 0)
+        rc = drv->next(ctx, IA_SET, &kv);
+    }
+    if (rc == 0)
+      rc = drv->done(ctx, IA_SET);
+    if (rc == 0) {
+      i += j;
+      __sync_synchronize();
+      shared->acked = i;
+    }
+  }
+
+  if (rc) {
+    ia_log("error: %s, the set failed (%d)", __func__, rc);
+    return rc;
+  }
+  /* all done, just wait to be killed */
+  for (;;)
+    pause();
+}
+
+/* The verifier: times the open (i.e. the recovery) in a fresh process, then
+ * checks the acknowledged keys and the ones of the in-flight transaction. */
+static int ia_crash_recover(struct iacrash_shared *shared) {
+  iadriver *drv = ioarena.driver;
+  iacrash *r = &shared->result;
+  struct ia_kvgen *gen = NULL;
+  iacontext *ctx = NULL;
+
+  ia_timestamp_t t0 = ia_timestamp_ns();
+  int rc = drv->open(ioarena.datadir);
+  r->recovery_ns = ia_timestamp_ns() - t0;
+  if (rc)
+    return rc;
+
+  ctx = drv->thread_new();
+  if (ctx == NULL)
+    rc = -1;
+  if (rc == 0)
+    rc = ia_kvgen_init(&gen, 0, 0, ioarena.conf.vsize, 0);
+
+  t0 = ia_timestamp_ns();
+  const uintmax_t total = r->acked + r->inflight;
+  for (uintmax_t i = 0; rc == 0 && i < total; ++i) {
+    iakv expected, kv;
+    rc = ia_kvgen_get(gen, &expected, 0);
+    if (rc)
+      break;
+    kv.k = expected.k;
+    kv.ksize = expected.ksize;
+    kv.v = NULL;
+    kv.vsize = 0;
+
+    rc = drv->begin(ctx, IA_GET);
+    if (rc == 0)
+      rc = drv->next(ctx, IA_GET, &kv);
+    const int found = (rc == 0);
+    /* not all drivers provide the value for get */
+    const int intact = !kv.v || (kv.vsize == expected.vsize &&
+                                 memcmp(kv.v, expected.v, kv.vsize) == 0);
+    if (rc == ENOENT)
+      rc = 0;
+    if (rc == 0)
+      rc = drv->done(ctx, IA_GET);
+
+    if (i < r->acked) {
+      r->lost += !found;
+      r->corrupted += found && !intact;
+    } else
+      r->inflight_survived += found && intact;
+  }
+  r->verify_ns = ia_timestamp_ns() - t0;
+
+  ia_kvgen_destroy(&gen);
+  if (ctx)
+    drv->thread_dispose(ctx);
+  drv->close();
+  return rc;
+}
+
+static int ia_crash_trial(struct iacrash_shared *shared, uintmax_t target) {
+  iacrash *r = &shared->result;
+  memset(shared, 0, sizeof(*shared));
+  r->target = target;
+
+  if (nftw(ioarena.datadir, ia_crash_unlink, 16, FTW_DEPTH | FTW_PHYS)) {
+    ia_log("error: %s, unable to cleanup %s, %s (%d)", __func__,
+           ioarena.datadir, strerror(errno), errno);
+    return -1;
+  }
+
+  fflush(NULL);
+  pid_t pid = fork();
+  if (pid < 0)
+    return -1;
+  if (pid == 0) {
+    int rc = ia_crash_writer(shared);
+    fflush(NULL);
+    _exit(rc ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+  int status;
+  while (shared->acked < target) {
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+      ia_log("error: %s, the writer is terminated prematurely", __func__);
+      return -1;
+    }
+    usleep(100);
+  }
+  kill(pid, SIGKILL);
+  if (waitpid(pid, &status, 0) != pid)
+    return -1;
+
+  r->acked = shared->acked;
+  r->inflight = ioarena.conf.count - r->acked;
+  if (r->inflight > (uintmax_t)ioarena.conf.txn_length)
+    r->inflight = ioarena.conf.txn_length;
+
+  fflush(NULL);
+  pid = fork();
+  if (pid < 0)
+    return -1;
+  if (pid == 0) {
+    int rc = ia_crash_recover(shared);
+    fflush(NULL);
+    _exit(rc ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+  if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != EXIT_SUCCESS) {
+    ia_log("error: %s, the recovery failed", __func__);
+    r->failed = 1;
+  }
+  return 0;
+}
+
+int ia_crash_run(ia *a) {
+  struct iacrash_shared *shared =
+      mmap(NULL, sizeof(struct iacrash_shared), PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    ia_log("error: %s, mmap() %s (%d)", __func__, strerror(errno), errno);
+    return -1;
+  }
+
+  /* the children inherit the generator's setup, the values are never
+   * deferred since the verification compares them */
+  int rc = ia_kvgen_setup(!a->conf.binary, a->conf.ksize, 1, 0, 1,
+                          a->conf.count, a->conf.kvseed, 0, a->conf.key_order,
+                          ia_key_window(&a->conf), a->conf.value_ratio,
+                          a->conf.key_format, a->conf.key_tenants,
+                          a->conf.key_tables);
+  if (rc) {
+    ia_log("error: key-value generator setup failed, the options are correct?");
+    goto bailout;
+  }
+  srandom((a->conf.kvseed < 0) ? time(NULL) : a->conf.kvseed);
+
+  printf("\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> "
+         "crash-recovery (%s)\n",
+         ia_syncmode2str(a->conf.syncmode));
+  FILE *csv = ia_csv_create(&a->conf, "crash");
+  printf("%5s %12s %12s %8s %8s %10s %10s %10s\n", "trial", "acked", "lost",
+         "corrupt", "inflight", "survived", "recovery", "verify");
+  if (csv)
+    fprintf(csv, "%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s\n", "trial",
+            "acked", "lost", "corrupted", "inflight", "inflight_survived",
+            "recovery", "verify", "failed");
+
+  ia_timestamp_t recovery_min = ~(ia_timestamp_t)0, recovery_max = 0;
+  double recovery_sum = 0;
+  uintmax_t lost = 0;
+  int lossy = 0, failed = 0;
+  for (int trial = 0; trial < a->conf.crashes; ++trial) {
+    const uintmax_t target =
+        1 + ((uintmax_t)random() << 31 | (uintmax_t)random()) % a->conf.count;
+    rc = ia_crash_trial(shared, target);
+    if (rc)
+      break;
+
+    const iacrash *r = &shared->result;
+    char recovery[32], verify[32];
+    ia_snpf_lat(recovery, sizeof(recovery), r->recovery_ns);
+    ia_snpf_lat(verify, sizeof(verify), r->verify_ns);
+    printf("%5d %12ju %12ju %8ju %8ju %10ju %10s %10s%s\n", trial + 1,
+           r->acked, r->lost, r->corrupted, r->inflight, r->inflight_survived,
+           recovery, verify, r->failed ? "  (failed)" : "");
+    if (csv)
+      fprintf(csv, "%d,\t%ju,\t%ju,\t%ju,\t%ju,\t%ju,\t%e,\t%e,\t%d\n",
+              trial + 1, r->acked, r->lost, r->corrupted, r->inflight,
+              r->inflight_survived, r->recovery_ns / (double)S,
+              r->verify_ns / (double)S, r->failed);
+    ia_report_crash(&a->conf, trial, r);
+
+    failed += r->failed;
+    if (r->failed)
+      continue;
+    lost += r->lost + r->corrupted;
+    lossy += (r->lost + r->corrupted) != 0;
+    recovery_sum += r->recovery_ns;
+    if (recovery_min > r->recovery_ns)
+      recovery_min = r->recovery_ns;
+    if (recovery_max < r->recovery_ns)
+      recovery_max = r->recovery_ns;
+  }
+  if (csv)
+    fclose(csv);
+
+  const int done = a->conf.crashes - failed;
+  if (rc == 0 && done > 0) {
+    char min[32], avg[32], max[32];
+    ia_snpf_lat(min, sizeof(min), recovery_min);
+    ia_snpf_lat(avg, sizeof(avg), recovery_sum / done);
+    ia_snpf_lat(max, sizeof(max), recovery_max);
+    printf("recovery:%s min,%s avg,%s max\n", min, avg, max);
+    printf("lost writes: %ju in %d of %d trial(s)\n", lost, lossy, done);
+  }
+  if (failed)
+    printf("failed recovery: %d of %d trial(s)\n", failed, a->conf.crashes);
+
+bailout:
+  munmap(shared, sizeof(struct iacrash_shared));
+  return (rc || failed) ? -1 : 0;
+}
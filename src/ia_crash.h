@@ -0,0 +1,31 @@
+﻿#pragma once
+#ifndef IA_CRASH_H_
+#define IA_CRASH_H_
+
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+typedef struct iacrash iacrash;
+
+#include "ia_time.h"
+
+/* the outcome of a single crash trial, see ia_crash_run() */
+struct iacrash {
+  uintmax_t target /* acknowledged writes to kill at */;
+  uintmax_t acked /* writes acknowledged before the kill */;
+  uintmax_t lost /* acknowledged, but missing after the recovery */;
+  uintmax_t corrupted /* acknowledged, but with a wrong value */;
+  uintmax_t inflight, inflight_survived /* not acknowledged ones */;
+  ia_timestamp_t recovery_ns /* of the driver's open() */;
+  ia_timestamp_t verify_ns;
+  int failed;
+};
+
+struct ia;
+int ia_crash_run(struct ia *a);
+
+#endif /* IA_CRASH_H_ */
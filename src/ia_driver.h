@@ -12,10 +12,19 @@
 typedef struct iadriver iadriver;
 typedef struct iaprivate iaprivate;
 typedef struct iacontext iacontext;
+typedef struct iacounter iacounter;
 
 #include "ia_histogram.h"
 #include "ia_kv.h"
 
+/* an engine's internal counter, e.g. pending compaction bytes.
+ * A driver must report the same counters in the same order every time. */
+struct iacounter {
+  const char *name;
+  double value;
+  int cumulative; /* a running total, shown as a delta per interval */
+};
+
 struct iadriver {
   const char *name;
   iaprivate *priv;
@@ -29,6 +38,19 @@ struct iadriver {
   int (*next)(iacontext *, iabenchmark, iakv *kv);
   int (*done)(iacontext *, iabenchmark);
   int (*option)(iacontext *, const char *arg);
+  const char *(*version)(void);
+  /* optional, polled at each checkpoint, returns the number of counters */
+  int (*counters)(iacounter *counters, int limit);
+  /* non-zero if the driver takes deferred values for set and renders them
+   * in-place by ia_kv_value(), e.g. into a space reserved by the engine */
+  int reserve;
+  /* optional, the update by the engine's native means (e.g. a merge
+   * operator) instead of get and set, i.e. increments each byte of the
+   * value in [offset, offset + length). ENOSYS when it is not enabled. */
+  int (*merge)(iacontext *, iakv *kv, size_t offset, size_t length);
+  /* optional, positions the iteration which is begun, so the following next
+   * returns the first key not less than the given one, ENOENT if none */
+  int (*seek)(iacontext *, iakv *kv);
 };
 
 #endif
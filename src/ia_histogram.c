@@ -7,9 +7,13 @@
  */
 
 #include "ioarena.h"
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #define INTERVAL_STAT S
 #define INTERVAL_MERGE (S / 100)
+#define INTERVAL_SAMPLE (S / 4)
 
 static const uintmax_t ia_histogram_buckets[ST_HISTOGRAM_COUNT] = {
 #define LINE_12_100(M)                                                         \
@@ -37,6 +41,13 @@ static const uintmax_t ia_histogram_buckets[ST_HISTOGRAM_COUNT] = {
 #undef LINE_12_100
 };
 
+struct iasample {
+  double counters[IA_MAX_COUNTERS] /* the raw values */;
+  iamemusage mem;
+  uintmax_t disk;
+  ia_timestamp_t disk_ns /* the datadir walk is refreshed less often */;
+};
+
 struct global {
   pthread_mutex_t mutex;
   ia_timestamp_t starting_point;
@@ -46,6 +57,19 @@ struct global {
   volatile int doers_active, doers_merged;
   int merge_evo;
   FILE *csv_timeline;
+  iatimepoint *timeline;
+  size_t timeline_length, timeline_allocated;
+  uintmax_t keys_carried, churned;
+  int ncounters;
+  const char *counter_names[IA_MAX_COUNTERS];
+  int counter_cumulative[IA_MAX_COUNTERS];
+  double counter_last[IA_MAX_COUNTERS];
+  /* the latest sample, see ia_histogram_sampler() */
+  pthread_mutex_t sample_mutex;
+  pthread_cond_t sample_cond;
+  pthread_t sampler;
+  int sampler_state /* 0 - none, 1 - running, 2 - stopping */;
+  struct iasample sample;
 };
 
 static struct global global;
@@ -54,6 +78,24 @@ void ia_global_init(void) {
   global.starting_point = ia_timestamp_ns();
   global.checkpoint_ns = global.starting_point;
   pthread_mutex_init(&global.mutex, NULL);
+  pthread_mutex_init(&global.sample_mutex, NULL);
+  pthread_cond_init(&global.sample_cond, NULL);
+}
+
+static void ia_histogram_sample(struct iasample *sample);
+
+void ia_histogram_rewind(void) {
+  global.keys_carried = ia_histogram_keys();
+  global.churned = 0;
+  /* (re)learn the counters and take the baseline for cumulative ones */
+  global.ncounters = -1;
+  global.sample.disk_ns = 0;
+  ia_histogram_sample(&global.sample);
+  memset(global.per_bench, 0, sizeof(global.per_bench));
+  global.starting_point = ia_timestamp_ns();
+  global.checkpoint_ns = global.starting_point;
+  global.doers_merged = 0;
+  global.timeline_length = 0;
 }
 
 void ia_histogram_reset(iahistogram *h, iabenchmark bench) {
@@ -88,13 +130,14 @@ void ia_histogram_destroy(iahistogram *h) {
   }
 }
 
-static FILE *csv_create(const iaconfig *config, const char *item) {
+FILE *ia_csv_create(const iaconfig *config, const char *item) {
   FILE *f = NULL;
 
   if (config->csv_prefix) {
     char path[PATH_MAX];
-    snprintf(path, sizeof(path), "%s%s_%s_%s.csv", config->csv_prefix,
-             config->driver, ia_syncmode2str(config->syncmode), item);
+    snprintf(path, sizeof(path), "%s%s_%s_%s%s%s.csv", config->csv_prefix,
+             config->driver, ia_syncmode2str(config->syncmode),
+             ioarena.round_tag, ioarena.round_tag[0] ? "_" : "", item);
     f = fopen(path, "w");
     if (!f)
       ia_log("error: %s, %s (%d)", path, strerror(errno), errno);
@@ -105,7 +148,7 @@ static FILE *csv_create(const iaconfig *config, const char *item) {
 
 void ia_histogram_csvopen(const iaconfig *config) {
   if (config->csv_prefix && !global.csv_timeline)
-    global.csv_timeline = csv_create(config, "timeline");
+    global.csv_timeline = ia_csv_create(config, "timeline");
 }
 
 void ia_histogram_csvclose(void) {
@@ -120,7 +163,7 @@ void ia_histogram_enable(iabenchmark bench) {
     ia_histogram_reset(&global.per_bench[bench], bench);
 }
 
-static int snpf_val(char *buf, size_t len, double val, const char *unit) {
+int ia_snpf_val(char *buf, size_t len, double val, const char *unit) {
   const char scale[] = "yzafpnum KMGTPEZY";
   const char *suffix = scale + 8;
   assert(*suffix == ' ');
@@ -139,9 +182,9 @@ static int snpf_val(char *buf, size_t len, double val, const char *unit) {
   return snprintf(buf, len, " %7.3f%c%s", val, *suffix, unit);
 }
 
-static int snpf_lat(char *buf, size_t len, ia_timestamp_t ns) {
+int ia_snpf_lat(char *buf, size_t len, ia_timestamp_t ns) {
 #if 1
-  return snpf_val(buf, len, ns / (double)S, "s");
+  return ia_snpf_val(buf, len, ns / (double)S, "s");
 #else
   const char *suffix = "us";
   double scale = 1.0 / US;
@@ -158,6 +201,123 @@ static int snpf_lat(char *buf, size_t len, ia_timestamp_t ns) {
 #endif
 }
 
+/* polls the engine's counters, the memory and the disk usage, which
+ * could be costly (e.g. parsing the engine's stats text and the smaps_rollup,
+ * walking a datadir of thousands of files), so it is done by the sampler
+ * thread rather than by a doer within the checkpoint. The datadir is walked
+ * once per INTERVAL_STAT only. The counters are learned at the rewind. */
+static void ia_histogram_sample(struct iasample *sample) {
+  iacounter counters[IA_MAX_COUNTERS];
+  const int n = ioarena.driver->counters
+                    ? ioarena.driver->counters(counters, IA_MAX_COUNTERS)
+                    : 0;
+
+  if (global.ncounters < 0) {
+    global.ncounters = (n > 0) ? n : 0;
+    for (int i = 0; i < global.ncounters; ++i) {
+      global.counter_names[i] = counters[i].name;
+      global.counter_cumulative[i] = counters[i].cumulative;
+      global.counter_last[i] =
+          isfinite(counters[i].value) ? counters[i].value : 0;
+    }
+  }
+
+  for (int i = 0; i < IA_MAX_COUNTERS; ++i)
+    sample->counters[i] = (i < n) ? counters[i].value : NAN;
+  ia_get_memusage(&sample->mem);
+
+  const ia_timestamp_t now = ia_timestamp_ns();
+  if (!sample->disk_ns || now - sample->disk_ns >= INTERVAL_STAT) {
+    uintmax_t disk = 0, disk_alloc;
+    ia_get_diskusage(ioarena.datadir, &disk, &disk_alloc);
+    sample->disk = disk;
+    sample->disk_ns = now;
+  }
+}
+
+static void *ia_histogram_sampler(void *arg) {
+  (void)arg;
+#ifdef __linux__
+  /* a low priority, but not an idle one, which starves under the load */
+  setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+#endif
+  if (pthread_mutex_lock(&global.sample_mutex))
+    ia_fatal(__FUNCTION__);
+  struct iasample sample = global.sample;
+  while (global.sampler_state == 1) {
+    pthread_mutex_unlock(&global.sample_mutex);
+    ia_histogram_sample(&sample);
+
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += INTERVAL_SAMPLE;
+    if (until.tv_nsec >= (long)S) {
+      until.tv_sec += 1;
+      until.tv_nsec -= S;
+    }
+
+    if (pthread_mutex_lock(&global.sample_mutex))
+      ia_fatal(__FUNCTION__);
+    global.sample = sample;
+    if (global.sampler_state == 1)
+      pthread_cond_timedwait(&global.sample_cond, &global.sample_mutex,
+                             &until);
+  }
+  pthread_mutex_unlock(&global.sample_mutex);
+  return NULL;
+}
+
+void ia_histogram_sampler_start(void) {
+  global.sampler_state = 1;
+  if (pthread_create(&global.sampler, NULL, ia_histogram_sampler, NULL)) {
+    ia_log("warning: no sampler thread, sampling at the checkpoints");
+    global.sampler_state = 0;
+  }
+}
+
+int ia_histogram_sampling(void) { return global.sampler_state == 1; }
+
+void ia_histogram_sampler_stop(void) {
+  if (global.sampler_state != 1)
+    return;
+  pthread_mutex_lock(&global.sample_mutex);
+  global.sampler_state = 2;
+  pthread_cond_signal(&global.sample_cond);
+  pthread_mutex_unlock(&global.sample_mutex);
+  pthread_join(global.sampler, NULL);
+  global.sampler_state = 0;
+}
+
+/* takes the latest sample (up to INTERVAL_SAMPLE old), or samples in
+ * place when there is no sampler (e.g. the final checkpoint), the cumulative
+ * counters are converted into deltas since the previous checkpoint. */
+static int ia_histogram_poll(struct iasample *sample, double *values) {
+  if (global.sampler_state == 1) {
+    pthread_mutex_lock(&global.sample_mutex);
+    *sample = global.sample;
+    pthread_mutex_unlock(&global.sample_mutex);
+  } else {
+    sample->disk_ns = 0;
+    ia_histogram_sample(sample);
+  }
+
+  for (int i = 0; i < global.ncounters; ++i) {
+    values[i] = sample->counters[i];
+    if (global.counter_cumulative[i] && isfinite(values[i])) {
+      const double total = values[i];
+      values[i] -= global.counter_last[i];
+      global.counter_last[i] = total;
+    }
+  }
+  return global.ncounters;
+}
+
+int ia_histogram_counters(const char **names) {
+  for (int i = 0; i < global.ncounters; ++i)
+    names[i] = global.counter_names[i];
+  return (global.ncounters > 0) ? global.ncounters : 0;
+}
+
 int ia_histogram_checkpoint(ia_timestamp_t now) {
   if (now) {
     if (now - global.checkpoint_ns < INTERVAL_STAT)
@@ -173,7 +333,11 @@ int ia_histogram_checkpoint(ia_timestamp_t now) {
     now = ia_timestamp_ns();
 
   iahistogram *h;
-  char line[1024], *s;
+  char line[1536], *s;
+
+  struct iasample sample;
+  double counters[IA_MAX_COUNTERS];
+  const int ncounters = ia_histogram_poll(&sample, counters);
 
   if (global.checkpoint_ns == global.starting_point) {
     s = line;
@@ -197,8 +361,18 @@ int ia_histogram_checkpoint(ia_timestamp_t now) {
                 name, name, name);
     }
 
-    if (global.csv_timeline)
+    s += snprintf(s, line + sizeof(line) - s,
+                  " |       rss      anon      file   ram/key      disk");
+    if (ncounters)
+      s += snprintf(s, line + sizeof(line) - s, " | %s", ioarena.driver->name);
+    if (global.csv_timeline) {
+      fprintf(global.csv_timeline,
+              ",\trss,\trss_anon,\trss_file,\tpss,\tpss_anon,\tpss_file,"
+              "\tkeys,\tram_per_key,\tdisk");
+      for (int i = 0; i < ncounters; ++i)
+        fprintf(global.csv_timeline, ",\t%s", global.counter_names[i]);
       fprintf(global.csv_timeline, "\n");
+    }
     ia_log("%s", line);
   }
 
@@ -212,6 +386,22 @@ int ia_histogram_checkpoint(ia_timestamp_t now) {
   const double wall = wall_ns / (double)S;
   global.checkpoint_ns = now;
 
+  iatimepoint *point = NULL;
+  if (global.timeline_length == global.timeline_allocated) {
+    size_t allocated = global.timeline_allocated * 2 + 64;
+    void *ptr = realloc(global.timeline, allocated * sizeof(iatimepoint));
+    if (ptr) {
+      global.timeline = ptr;
+      global.timeline_allocated = allocated;
+    }
+  }
+  if (global.timeline_length < global.timeline_allocated) {
+    point = &global.timeline[global.timeline_length++];
+    memset(point, 0, sizeof(*point));
+    point->time = timepoint;
+    point->wall = wall;
+  }
+
   for (h = global.per_bench; h < global.per_bench + IA_MAX; ++h) {
     if (!h->enabled)
       continue;
@@ -229,6 +419,16 @@ int ia_histogram_checkpoint(ia_timestamp_t now) {
       const double rps = n / wall;
       const double bps = vol / wall;
 
+      if (point) {
+        point->bench[h->bench].n = n;
+        point->bench[h->bench].ops = h->acc.ops - h->last.ops;
+        point->bench[h->bench].volume = vol;
+        point->bench[h->bench].min = h->min;
+        point->bench[h->bench].avg = avg;
+        point->bench[h->bench].rms = rms;
+        point->bench[h->bench].max = h->max;
+      }
+
       if (global.csv_timeline) {
         fprintf(global.csv_timeline, ",\t%e,\t%e,\t%e,\t%e,\t%e", rps,
                 h->min / (double)S, avg / (double)S, rms / (double)S,
@@ -236,21 +436,21 @@ int ia_histogram_checkpoint(ia_timestamp_t now) {
       }
 
       s += snprintf(s, line + sizeof(line) - s, ":");
-      s += snpf_val(s, line + sizeof(line) - s, rps, "");
-      s += snpf_lat(s, line + sizeof(line) - s, h->min);
-      s += snpf_lat(s, line + sizeof(line) - s, avg);
-      s += snpf_lat(s, line + sizeof(line) - s, rms);
-      s += snpf_lat(s, line + sizeof(line) - s, h->max);
-
-      s += snpf_val(s, line + sizeof(line) - s, bps, "bps");
-      s += snpf_val(s, line + sizeof(line) - s, h->acc.n, "");
+      s += ia_snpf_val(s, line + sizeof(line) - s, rps, "");
+      s += ia_snpf_lat(s, line + sizeof(line) - s, h->min);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, avg);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, rms);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, h->max);
+
+      s += ia_snpf_val(s, line + sizeof(line) - s, bps, "bps");
+      s += ia_snpf_val(s, line + sizeof(line) - s, h->acc.n, "");
     } else {
       s += snprintf(s, line + sizeof(line) - s,
                     "        -        -         -  "
                     "       -         -         -  "
                     "         - ");
       if (global.csv_timeline) {
-        fprintf(global.csv_timeline, ",\t\t,\t\t,\t\t,\t\t");
+        fprintf(global.csv_timeline, ",\t\t,\t\t,\t\t,\t\t,\t\t");
       }
     }
 
@@ -265,7 +465,40 @@ int ia_histogram_checkpoint(ia_timestamp_t now) {
     h->last = h->acc;
   }
 
+  const iamemusage mem = sample.mem;
+  const uintmax_t keys = ia_histogram_keys();
+  const double per_key = ia_histogram_ram_per_key(&mem, keys);
+  const uintmax_t disk = sample.disk;
+  if (point) {
+    point->mem = mem;
+    point->keys = keys;
+    point->disk = disk;
+    memcpy(point->counters, counters, sizeof(counters));
+  }
+
+  s += snprintf(s, line + sizeof(line) - s, " |");
+  s += ia_snpf_val(s, line + sizeof(line) - s, mem.rss, "B");
+  s += ia_snpf_val(s, line + sizeof(line) - s, mem.rss_anon, "B");
+  s += ia_snpf_val(s, line + sizeof(line) - s, mem.rss_file, "B");
+  if (isfinite(per_key))
+    s += ia_snpf_val(s, line + sizeof(line) - s, per_key, "B");
+  else
+    s += snprintf(s, line + sizeof(line) - s, "         -");
+  s += ia_snpf_val(s, line + sizeof(line) - s, disk, "B");
+  if (ncounters)
+    s += snprintf(s, line + sizeof(line) - s, " |");
+  for (int i = 0; i < ncounters; ++i) {
+    s += snprintf(s, line + sizeof(line) - s, " %s", global.counter_names[i]);
+    s += ia_snpf_val(s, line + sizeof(line) - s, counters[i], "");
+  }
+
   if (global.csv_timeline) {
+    fprintf(global.csv_timeline,
+            ",\t%ju,\t%ju,\t%ju,\t%ju,\t%ju,\t%ju,\t%ju,\t%e,\t%ju", mem.rss,
+            mem.rss_anon, mem.rss_file, mem.pss, mem.pss_anon, mem.pss_file,
+            keys, per_key, disk);
+    for (int i = 0; i < ncounters; ++i)
+      fprintf(global.csv_timeline, ",\t%e", counters[i]);
     fprintf(global.csv_timeline, "\n");
     fflush(global.csv_timeline);
   }
@@ -285,7 +518,9 @@ static void ia_histogram_merge_locked(iahistogram *src, ia_timestamp_t now) {
     dst->acc.latency_sum_square +=
         src->acc.latency_sum_square - src->last.latency_sum_square;
     dst->acc.volume_sum += src->acc.volume_sum - src->last.volume_sum;
+    dst->acc.ops += src->acc.ops - src->last.ops;
     dst->acc.n += src->acc.n - src->last.n;
+    dst->acc.aborts += src->acc.aborts - src->last.aborts;
 
     int i;
     for (i = 0; i < ST_HISTOGRAM_COUNT; i++)
@@ -316,7 +551,10 @@ void ia_histogram_merge(iahistogram *src) {
   }
 }
 
-void ia_histogram_add(iahistogram *h, ia_timestamp_t t0, size_t volume) {
+void ia_histogram_abort(iahistogram *h) { h->acc.aborts++; }
+
+void ia_histogram_add(iahistogram *h, ia_timestamp_t t0, size_t ops,
+                      size_t volume) {
   uintmax_t now = ia_timestamp_ns();
   ia_timestamp_t latency = now - t0;
 
@@ -326,6 +564,7 @@ void ia_histogram_add(iahistogram *h, ia_timestamp_t t0, size_t volume) {
   h->acc.latency_sum_ns += latency;
   h->acc.latency_sum_square += latency * latency;
   h->acc.n++;
+  h->acc.ops += ops;
   h->acc.volume_sum += volume;
   if (h->min > latency)
     h->min = latency;
@@ -380,7 +619,7 @@ void ia_histogram_print(const iaconfig *config) {
     printf("\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> "
            "%s(%ju)\n",
            name, h->acc.n);
-    FILE *csv = csv_create(config, name);
+    FILE *csv = ia_csv_create(config, name);
 
     printf("[%8s   %8s   ]%16s%8s%10s\n", "ltn_from", "ltn_to", "ops_count",
            "%", "p%");
@@ -400,10 +639,10 @@ void ia_histogram_print(const iaconfig *config) {
       n += h->buckets[i];
       s = line;
       s += snprintf(s, line + sizeof(line) - s, "[");
-      s += snpf_lat(s, line + sizeof(line) - s,
+      s += ia_snpf_lat(s, line + sizeof(line) - s,
                     (i > 0) ? ia_histogram_buckets[i - 1] : 0);
       s += snprintf(s, line + sizeof(line) - s, ",");
-      s += snpf_lat(s, line + sizeof(line) - s, ia_histogram_buckets[i] - 1);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, ia_histogram_buckets[i] - 1);
       s += snprintf(s, line + sizeof(line) - s, " ]%16zu%7.2f%%%9.4f%%",
                     h->buckets[i], h->buckets[i] * 1e2 / h->acc.n,
                     n * 1e2 / h->acc.n);
@@ -418,24 +657,31 @@ void ia_histogram_print(const iaconfig *config) {
     }
     printf("----------------------------------------------------------\n");
 
-    snpf_lat(line, sizeof(line), h->acc.latency_sum_ns);
+    ia_snpf_lat(line, sizeof(line), h->acc.latency_sum_ns);
     printf("total:%16s  %16zu\n", line, n);
-    snpf_lat(line, sizeof(line), h->whole_min);
+    ia_snpf_lat(line, sizeof(line), h->whole_min);
     printf("min latency:%s/op\n", line);
     const ia_timestamp_t avg = h->acc.latency_sum_ns / h->acc.n;
-    snpf_lat(line, sizeof(line), avg);
+    ia_snpf_lat(line, sizeof(line), avg);
     printf("avg latency:%s/op\n", line);
     const ia_timestamp_t rms = sqrt(h->acc.latency_sum_square / h->acc.n);
-    snpf_lat(line, sizeof(line), rms);
+    ia_snpf_lat(line, sizeof(line), rms);
     printf("rms latency:%s/op\n", line);
-    snpf_lat(line, sizeof(line), h->whole_max);
+    ia_snpf_lat(line, sizeof(line), h->whole_max);
     printf("max latency:%s/op\n", line);
 
     const ia_timestamp_t wall_ns = h->end_ns - h->begin_ns;
     const double wall = wall_ns / (double)S;
     const double rps = h->acc.n / wall;
-    snpf_val(line, sizeof(line), rps, "");
+    ia_snpf_val(line, sizeof(line), rps, "");
     printf(" throughput:%sops/s\n", line);
+    if (h->acc.ops != h->acc.n) {
+      ia_snpf_val(line, sizeof(line), h->acc.ops / wall, "");
+      printf("    op-rate:%sops/s\n", line);
+    }
+    if (h->acc.aborts)
+      printf("     aborts: %ju, %.2f%% of attempts\n", h->acc.aborts,
+             h->acc.aborts * 1e2 / (h->acc.n + h->acc.aborts));
 
     if (csv) {
       fprintf(csv, "\n%s,\t%s,\t%s,\t%s,\t%s\n", "ltn_min", "ltn_avg",
@@ -447,11 +693,145 @@ void ia_histogram_print(const iaconfig *config) {
   }
 }
 
+ia_timestamp_t ia_histogram_percentile(const iahistogram *h, double p) {
+  const double target = h->acc.n * p / 1e2;
+  uintmax_t n = 0;
+  int i;
+
+  for (i = 0; i < ST_HISTOGRAM_COUNT; i++) {
+    if (!h->buckets[i] || n + h->buckets[i] < target) {
+      n += h->buckets[i];
+      continue;
+    }
+
+    /* linear interpolation inside the bucket */
+    const ia_timestamp_t from = (i > 0) ? ia_histogram_buckets[i - 1] : 0;
+    const ia_timestamp_t to = ia_histogram_buckets[i] - 1;
+    ia_timestamp_t ns = from + (to - from) * (target - n) / h->buckets[i];
+    if (ns < h->whole_min)
+      ns = h->whole_min;
+    if (ns > h->whole_max)
+      ns = h->whole_max;
+    return ns;
+  }
+  return h->whole_max;
+}
+
+const iahistogram *ia_histogram_of(iabenchmark bench) {
+  return &global.per_bench[bench];
+}
+
+ia_timestamp_t ia_histogram_bucket_bound(int i) {
+  return ia_histogram_buckets[i];
+}
+
+const iatimepoint *ia_histogram_timeline(size_t *count) {
+  *count = global.timeline_length;
+  return global.timeline;
+}
+
+/* an estimation of the number of keys in the database, i.e. written by
+ * set/crud/batch minus deleted. Since each round (re)writes the same keys,
+ * the previous rounds are carried as a maximum rather than a sum. */
+uintmax_t ia_histogram_keys(void) {
+  const iahistogram *h = global.per_bench;
+  const intmax_t net = h[IA_SET].acc.ops + h[IA_CRUD].acc.ops +
+                       h[IA_BATCH].acc.ops - h[IA_DELETE].acc.ops -
+                       global.churned;
+  if (net < 0)
+    return ((uintmax_t)-net < global.keys_carried) ? global.keys_carried + net
+                                                   : 0;
+  return ((uintmax_t)net > global.keys_carried) ? (uintmax_t)net
+                                                : global.keys_carried;
+}
+
+/* accounts a key deleted by the soak's churn */
+void ia_histogram_churn(void) { __sync_fetch_and_add(&global.churned, 1); }
+
+/* RSS growth since the database was opened, per stored key */
+double ia_histogram_ram_per_key(const iamemusage *mem, uintmax_t keys) {
+  if (!keys || mem->rss <= ioarena.before_open_mem.rss)
+    return NAN;
+  return (mem->rss - ioarena.before_open_mem.rss) / (double)keys;
+}
+
+/* the compression achieved by the engine itself, i.e. the driver's counter
+ * named "compression", since the allocated space also includes the pages'
+ * fill, the obsolete versions and so on; NAN if not reported */
+static double ia_histogram_compression(void) {
+  iacounter counters[IA_MAX_COUNTERS];
+  const int ncounters =
+      ioarena.driver->counters
+          ? ioarena.driver->counters(counters, IA_MAX_COUNTERS)
+          : 0;
+  for (int i = 0; i < ncounters; ++i)
+    if (strcmp(counters[i].name, "compression") == 0)
+      return counters[i].value;
+  return NAN;
+}
+
+void ia_histogram_amplification(const iaconfig *config, const iarusage *start,
+                                const iarusage *fihish, iaamplification *amp) {
+  amp->logical =
+      ia_histogram_keys() * (uintmax_t)(config->ksize + config->vsize);
+  amp->allocated = fihish->disk_alloc - start->disk_alloc;
+  amp->user_written = 0;
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++)
+    if (bench_mask_write & (1l << bench))
+      amp->user_written += global.per_bench[bench].acc.volume_sum;
+  amp->device_written = fihish->io_write_bytes - start->io_write_bytes;
+  amp->device_read = fihish->io_read_bytes - start->io_read_bytes;
+  amp->space = amp->logical ? amp->allocated / (double)amp->logical : NAN;
+  amp->compression = ia_histogram_compression();
+  amp->write =
+      amp->user_written ? amp->device_written / (double)amp->user_written : NAN;
+}
+
+int ia_histogram_summary(iabenchmark bench, iasummary *sum) {
+  const iahistogram *h = &global.per_bench[bench];
+  memset(sum, 0, sizeof(*sum));
+  if (!h->enabled || !h->acc.n)
+    return -1;
+
+  sum->n = h->acc.n;
+  sum->ops = h->acc.ops;
+  sum->volume = h->acc.volume_sum;
+  sum->aborts = h->acc.aborts;
+  sum->abort_rate =
+      sum->aborts ? sum->aborts / (double)(sum->n + sum->aborts) : 0;
+  sum->begin_ns = h->begin_ns;
+  sum->end_ns = h->end_ns;
+  sum->wall = (h->end_ns - h->begin_ns) / (double)S;
+  if (sum->wall > 0) {
+    sum->rps = sum->n / sum->wall;
+    sum->ops_rate = sum->ops / sum->wall;
+    sum->bps = sum->volume / sum->wall;
+  }
+  sum->min = h->whole_min;
+  sum->avg = h->acc.latency_sum_ns / h->acc.n;
+  sum->rms = sqrt(h->acc.latency_sum_square / h->acc.n);
+  sum->max = h->whole_max;
+  sum->p50 = ia_histogram_percentile(h, 50);
+  sum->p90 = ia_histogram_percentile(h, 90);
+  sum->p99 = ia_histogram_percentile(h, 99);
+  sum->p999 = ia_histogram_percentile(h, 99.9);
+  return 0;
+}
+
+/* the ratios are NaN when nothing was written or is live */
+static void ia_snpf_ratio(char *buf, size_t len, double ratio,
+                          const char *suffix) {
+  if (isfinite(ratio))
+    snprintf(buf, len, "%.2f%s", ratio, suffix);
+  else
+    snprintf(buf, len, "n/a");
+}
+
 void ia_histogram_rusage(const iaconfig *config, const iarusage *start,
                          const iarusage *fihish) {
   printf(
       "\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> rusage\n");
-  FILE *csv = csv_create(config, "rusage");
+  FILE *csv = ia_csv_create(config, "rusage");
 
   printf("iops: read %ld, write %ld, page %ld\n",
          fihish->iops_read - start->iops_read,
@@ -466,17 +846,68 @@ void ia_histogram_rusage(const iaconfig *config, const iarusage *start,
   printf("space: disk %f, ram %f\n", (fihish->disk - start->disk) / mb,
          (fihish->ram - start->ram) / mb);
 
+  const iamemusage *mem = &fihish->mem;
+  uintmax_t peak = mem->rss;
+  for (size_t i = 0; i < global.timeline_length; ++i)
+    if (peak < global.timeline[i].mem.rss)
+      peak = global.timeline[i].mem.rss;
+  printf("memory: rss %f (anon %f, file %f), pss %f (anon %f, file %f), "
+         "peak rss %f\n",
+         mem->rss / mb, mem->rss_anon / mb, mem->rss_file / mb, mem->pss / mb,
+         mem->pss_anon / mb, mem->pss_file / mb, peak / mb);
+  const uintmax_t keys = ia_histogram_keys();
+  const double per_key = ia_histogram_ram_per_key(mem, keys);
+  if (isfinite(per_key))
+    printf("ram per key: %.1f bytes (~%ju keys)\n", per_key, keys);
+
+  iaamplification amp;
+  ia_histogram_amplification(config, start, fihish, &amp);
+  char space[16], write[16], compression[16];
+  ia_snpf_ratio(space, sizeof(space), amp.space, "");
+  ia_snpf_ratio(write, sizeof(write), amp.write, "");
+  ia_snpf_ratio(compression, sizeof(compression), amp.compression, ":1");
+  printf("amplification: logical %f, allocated %f, space-amp %s; "
+         "written %f, device write %f (read %f), write-amp %s\n",
+         amp.logical / mb, amp.allocated / mb, space, amp.user_written / mb,
+         amp.device_written / mb, amp.device_read / mb, write);
+  if (config->value_ratio > 1)
+    printf("compression: target %.2f:1 of values, achieved %s by the engine\n",
+           config->value_ratio, compression);
+  else if (isfinite(amp.compression))
+    printf("compression: achieved %s by the engine\n", compression);
+
+  iacounter counters[IA_MAX_COUNTERS];
+  const int ncounters =
+      ioarena.driver->counters
+          ? ioarena.driver->counters(counters, IA_MAX_COUNTERS)
+          : 0;
+  if (ncounters > 0) {
+    printf("%s:", ioarena.driver->name);
+    for (int i = 0; i < ncounters; ++i)
+      printf("%s %s %g", i ? "," : "", counters[i].name, counters[i].value);
+    printf("\n");
+  }
+
   if (csv) {
-    fprintf(csv, "%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s\n", "iops_read",
-            "iops_write", "iops_page", "cpu_user_ns", "cpu_kernel_ns", "disk",
-            "ram");
-    fprintf(csv, "%ju,\t%ju,\t%ju,\t%e,\t%e,\t%e,\t%e\n",
+    fprintf(csv, "%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,"
+                 "\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s\n",
+            "iops_read", "iops_write", "iops_page", "cpu_user_ns",
+            "cpu_kernel_ns", "disk", "ram", "rss", "rss_anon", "rss_file",
+            "pss", "peak_rss", "keys", "ram_per_key", "disk_alloc", "logical",
+            "user_written", "device_written", "device_read", "space_amp",
+            "compression", "write_amp");
+    fprintf(csv, "%ju,\t%ju,\t%ju,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,"
+                 "\t%ju,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e\n",
             fihish->iops_read - start->iops_read,
             fihish->iops_write - start->iops_write,
             fihish->iops_page - start->iops_page,
             (fihish->cpu_user_ns - start->cpu_user_ns) * 1e-9,
             (fihish->cpu_kernel_ns - start->cpu_kernel_ns) * 1e-9,
-            (fihish->disk - start->disk) / mb, (fihish->ram - start->ram) / mb);
+            (fihish->disk - start->disk) / mb, (fihish->ram - start->ram) / mb,
+            mem->rss / mb, mem->rss_anon / mb, mem->rss_file / mb,
+            mem->pss / mb, peak / mb, keys, per_key, amp.allocated / mb,
+            amp.logical / mb, amp.user_written / mb, amp.device_written / mb,
+            amp.device_read / mb, amp.space, amp.compression, amp.write);
     fclose(csv);
   }
 }
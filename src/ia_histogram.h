@@ -10,16 +10,21 @@
  */
 
 typedef struct iahistogram iahistogram;
+typedef struct iasummary iasummary;
+typedef struct iatimepoint iatimepoint;
+typedef struct iaamplification iaamplification;
 
 #include "ia_config.h"
 #include "ia_rusage.h"
 #include "ia_time.h"
 
 #define ST_HISTOGRAM_COUNT 167
+#define IA_MAX_COUNTERS 8
 
 struct iastat {
   uintmax_t latency_sum_ns, latency_sum_square;
-  uintmax_t n, volume_sum;
+  uintmax_t n, ops, volume_sum;
+  uintmax_t aborts /* the conflicts which were retried */;
 };
 
 struct iahistogram {
@@ -34,17 +39,71 @@ struct iahistogram {
   int merge_evo;
 };
 
+struct iasummary {
+  uintmax_t n, ops, volume, aborts;
+  double abort_rate /* per attempt */;
+  ia_timestamp_t begin_ns, end_ns;
+  double wall, rps, ops_rate, bps;
+  ia_timestamp_t min, avg, rms, max;
+  ia_timestamp_t p50, p90, p99, p999;
+};
+
+struct iatimepoint {
+  double time, wall;
+  struct {
+    uintmax_t n, ops, volume;
+    ia_timestamp_t min, avg, rms, max;
+  } bench[IA_MAX];
+  iamemusage mem;
+  uintmax_t keys;
+  uintmax_t disk /* the size of the database files */;
+  double counters[IA_MAX_COUNTERS];
+};
+
+/* the space amplification is the allocated space per logical (live) bytes,
+ * the compression is the raw bytes per stored ones as reported by the engine,
+ * the write amplification is the bytes written to the storage per bytes
+ * written by the benchmarks; NAN if not applicable */
+struct iaamplification {
+  uintmax_t logical, allocated;
+  uintmax_t user_written, device_written, device_read;
+  double space, compression, write;
+};
+
 void ia_histogram_init(iahistogram *h);
 void ia_histogram_reset(iahistogram *h, iabenchmark bench);
 void ia_histogram_destroy(iahistogram *h);
-void ia_histogram_add(iahistogram *h, ia_timestamp_t t0, size_t volume);
+void ia_histogram_add(iahistogram *h, ia_timestamp_t t0, size_t ops,
+                      size_t volume);
 void ia_histogram_merge(iahistogram *src);
+void ia_histogram_abort(iahistogram *h);
 
 int ia_histogram_checkpoint(ia_timestamp_t now);
 void ia_histogram_print(const iaconfig *config);
 void ia_histogram_csvopen(const iaconfig *config);
 void ia_histogram_csvclose(void);
 void ia_histogram_enable(iabenchmark bench);
+void ia_histogram_rewind(void);
+void ia_histogram_sampler_start(void);
+void ia_histogram_sampler_stop(void);
+/* non-zero while the counters are polled every INTERVAL_SAMPLE by the
+ * sampler thread, so a driver could skip the costly ones until the end */
+int ia_histogram_sampling(void);
+ia_timestamp_t ia_histogram_percentile(const iahistogram *h, double p);
+int ia_histogram_summary(iabenchmark bench, iasummary *sum);
+const iahistogram *ia_histogram_of(iabenchmark bench);
+ia_timestamp_t ia_histogram_bucket_bound(int i);
+const iatimepoint *ia_histogram_timeline(size_t *count);
+int ia_histogram_counters(const char **names);
+uintmax_t ia_histogram_keys(void);
+void ia_histogram_churn(void);
+double ia_histogram_ram_per_key(const iamemusage *mem, uintmax_t keys);
+void ia_histogram_amplification(const iaconfig *config, const iarusage *start,
+                                const iarusage *fihish, iaamplification *amp);
+
+FILE *ia_csv_create(const iaconfig *config, const char *item);
+int ia_snpf_val(char *buf, size_t len, double val, const char *unit);
+int ia_snpf_lat(char *buf, size_t len, ia_timestamp_t ns);
 
 void ia_histogram_rusage(const iaconfig *config, const iarusage *start,
                          const iarusage *fihish);
@@ -28,6 +28,14 @@ static const unsigned char alphabet[ALPHABET_CARDINALITY] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
     "_";
 
+/* the same in the bytewise order */
+static const unsigned char alphabet_sorted[ALPHABET_CARDINALITY] =
+    "0123456789"
+    "@"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "_"
+    "abcdefghijklmnopqrstuvwxyz";
+
 #define BITMASK(n) (~UINTMAX_C(0) >> (64 - (n)))
 #define ALIGN(n) (((n) + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1))
 
@@ -35,45 +43,74 @@ static void kv_sbox_init(unsigned seed);
 static uint64_t kv_mod2n_injection(uint64_t x);
 static size_t kvpair_bytes(size_t vsize);
 static char *kv_pair(unsigned vsize, unsigned vage, uint64_t point, char *dst);
+static char *kv_fill(uint64_t *point, char *dst, unsigned length, char exact);
+static char *kv_terminate(char *dst);
+static uint64_t kv_permute(uint64_t serial, uint64_t span);
+static void kv_digits(uint64_t number, char *dst, unsigned length);
+static char *kv_key(uint64_t *point, char *dst);
+static char *kv_value(uint64_t *point, char *dst, unsigned length, char exact);
 
 static struct {
-  char debug, printable;
-  unsigned ksize, width, nsectors;
-  uint64_t period;
+  char debug, printable, deferred;
+  unsigned ksize, width, nspaces, nsectors;
+  uint64_t period, ntop /* the key spaces fitting the width */;
+  iakeyorder order;
+  unsigned window;
+  double vratio /* the compressibility of values, 1 for none */;
+  iakeyformat format;
+  unsigned tenants, tables, tenant_len, table_len;
+  unsigned point_len /* the digits of the point within a key */;
 } kv_globals = {
     .debug = DEBUG_KEYGEN,
 };
 
-int ia_kvgen_setup(char printable, unsigned ksize, unsigned nspaces,
-                   unsigned nsectors, uintmax_t period, int seed) {
-  uint64_t top;
+static unsigned kv_width(double maxkey, uint64_t *top) {
   unsigned width;
-
-  double maxkey = (double)period * (double)nspaces;
-  if (maxkey < 2) {
-    return -1;
-  } else if (maxkey < BITMASK(16)) {
+  if (maxkey < BITMASK(16)) {
     width = 16 / 8;
-    top = BITMASK(16);
+    *top = BITMASK(16);
   } else if (maxkey < BITMASK(24)) {
     width = 24 / 8;
-    top = BITMASK(24);
+    *top = BITMASK(24);
   } else if (maxkey < BITMASK(32)) {
     width = 32 / 8;
-    top = BITMASK(32);
+    *top = BITMASK(32);
   } else if (maxkey < BITMASK(40)) {
     width = 40 / 8;
-    top = BITMASK(40);
+    *top = BITMASK(40);
   } else if (maxkey < BITMASK(48)) {
     width = 48 / 8;
-    top = BITMASK(48);
+    *top = BITMASK(48);
   } else if (maxkey < (double) BITMASK(56)) {
     width = 56 / 8;
-    top = BITMASK(56);
+    *top = BITMASK(56);
   } else if (maxkey < (double) UINT64_MAX) {
     width = 64 / 8;
-    top = UINT64_MAX;
-  } else {
+    *top = UINT64_MAX;
+  } else
+    width = 0;
+  return width;
+}
+
+int ia_kvgen_setup(char printable, unsigned ksize, unsigned nspaces,
+                   unsigned nreserved, unsigned nsectors, uintmax_t period,
+                   int seed, char deferred, iakeyorder order, unsigned window,
+                   double vratio, iakeyformat format, unsigned tenants,
+                   unsigned tables) {
+  uint64_t top;
+  const unsigned radix = printable ? ALPHABET_CARDINALITY : 256;
+
+  double maxkey = (double)period * (double)nspaces;
+  if (maxkey < 2)
+    return -1;
+  unsigned width = kv_width(maxkey, &top);
+  /* the reserved key spaces are taken from the top of the width, so they
+   * don't change the width (i.e. the keys) unless there is no headroom */
+  if (width && top / period < (uint64_t)nspaces + nreserved) {
+    maxkey = (double)top + 1;
+    width = kv_width(maxkey, &top);
+  }
+  if (!width) {
     double width = log(maxkey) / log(2);
     ia_log("key-gen: %u sector of %ju items is too huge, unable provide by "
            "%u-bit arithmetics, at least %d required",
@@ -81,7 +118,16 @@ int ia_kvgen_setup(char printable, unsigned ksize, unsigned nspaces,
     return -1;
   }
 
-  double bytes4maxkey = log(top) / log(printable ? ALPHABET_CARDINALITY : 256);
+  /* the prefixes are the big-endian digits, wide enough for the ids */
+  unsigned tenant_len = 0, table_len = 0;
+  if (format == IA_KEY_PREFIX) {
+    for (tenant_len = 1; pow(radix, tenant_len) < tenants;)
+      ++tenant_len;
+    for (table_len = 1; pow(radix, table_len) < tables;)
+      ++table_len;
+  }
+
+  double bytes4maxkey = log(top) / log(radix) + tenant_len + table_len;
   if (bytes4maxkey > (double)ksize) {
     ia_log("key-gen: key-length %u is insufficient for %u sectors of %s %ju "
            "items, at least %d required",
@@ -94,8 +140,25 @@ int ia_kvgen_setup(char printable, unsigned ksize, unsigned nspaces,
   kv_globals.printable = printable;
   kv_globals.ksize = ksize;
   kv_globals.period = period;
+  kv_globals.ntop = top / period;
   kv_globals.width = width;
+  kv_globals.nspaces = nspaces;
   kv_globals.nsectors = nsectors;
+  kv_globals.deferred = deferred;
+  kv_globals.order = order;
+  kv_globals.window = (order == IA_ORDER_BATCH && window > 1) ? window : 0;
+  kv_globals.vratio = (vratio > 1) ? vratio : 1;
+  kv_globals.format = format;
+  kv_globals.tenants = tenant_len ? tenants : 1;
+  kv_globals.tables = table_len ? tables : 1;
+  kv_globals.tenant_len = tenant_len;
+  kv_globals.table_len = table_len;
+  /* the random keys take just the digits for the width, the scrambled tail
+   * follows, the others are the fixed-width integers up to the key size */
+  const unsigned bits = printable ? 6 : 8;
+  kv_globals.point_len = ksize - tenant_len - table_len;
+  if (format == IA_KEY_RANDOM && (width * 8 + bits - 1) / bits < ksize)
+    kv_globals.point_len = (width * 8 + bits - 1) / bits;
 
   if (seed < 0)
     seed = time(NULL);
@@ -104,19 +167,87 @@ int ia_kvgen_setup(char printable, unsigned ksize, unsigned nspaces,
 }
 
 struct ia_kvgen {
-  uint64_t base, serial;
+  uint64_t base, serial, span;
   unsigned vsize, vage, pair_bytes;
+  /* the sorted batch: the points with their keys, see kv_window_fill() */
+  char *window;
+  unsigned wpos, wlen;
   char buf[];
 };
 
+static size_t kv_window_bytes(void) {
+  return sizeof(uint64_t) + ALIGN(kv_globals.ksize + 1);
+}
+
+static int kv_window_cmp(const void *a, const void *b) {
+  return memcmp((const char *)a + sizeof(uint64_t),
+                (const char *)b + sizeof(uint64_t), kv_globals.ksize);
+}
+
+/* The keys are the same for every order, i.e. the order is of the points:
+ * the ascending and descending go by the serial, the random permutes it. */
+static uint64_t kv_serial_point(struct ia_kvgen *gen) {
+  uint64_t point = gen->serial;
+  gen->serial = (gen->serial + 1) % gen->span;
+  switch (kv_globals.order) {
+  case IA_ORDER_ASC:
+    break;
+  case IA_ORDER_DESC:
+    point = gen->span - 1 - point;
+    break;
+  default:
+    point = kv_permute(point, gen->span);
+  }
+  return gen->base + point;
+}
+
+/* The sorted batch takes the next window of the random order and sorts it,
+ * so the set of each window is the same as for the random order. */
+static void kv_window_fill(struct ia_kvgen *gen) {
+  const size_t bytes = kv_window_bytes();
+  for (unsigned i = 0; i < kv_globals.window; ++i) {
+    char *item = gen->window + i * bytes;
+    const uint64_t point = kv_serial_point(gen);
+    memcpy(item, &point, sizeof(point));
+    uint64_t x = point;
+    kv_key(&x, item + sizeof(uint64_t));
+  }
+  qsort(gen->window, kv_globals.window, bytes, kv_window_cmp);
+  gen->wpos = 0;
+  gen->wlen = kv_globals.window;
+}
+
+static uint64_t kv_next_point(struct ia_kvgen *gen) {
+  uint64_t point;
+  if (kv_globals.window) {
+    if (gen->wpos == gen->wlen)
+      kv_window_fill(gen);
+    memcpy(&point, gen->window + gen->wpos++ * kv_window_bytes(),
+           sizeof(point));
+    return point;
+  }
+  return kv_serial_point(gen);
+}
+
 int ia_kvgen_init(struct ia_kvgen **genptr, unsigned kspace, unsigned ksector,
                   unsigned vsize, unsigned vage) {
   size_t pair_size = kvpair_bytes(vsize);
+  char *window = *genptr ? (*genptr)->window : NULL;
   struct ia_kvgen *gen = realloc(*genptr, sizeof(struct ia_kvgen) + pair_size);
   if (!gen)
     return -1;
+  *genptr = gen;
+
+  gen->window = window;
+  gen->wpos = gen->wlen = 0;
+  if (kv_globals.window) {
+    gen->window = realloc(window, kv_globals.window * kv_window_bytes());
+    if (!gen->window)
+      return -1;
+  }
 
   gen->base = kspace * kv_globals.period;
+  gen->span = kv_globals.period;
   gen->serial = 0;
   if (ksector) {
     gen->serial = kv_globals.period * (double)ksector / kv_globals.nsectors;
@@ -125,14 +256,26 @@ int ia_kvgen_init(struct ia_kvgen **genptr, unsigned kspace, unsigned ksector,
   gen->vsize = vsize;
   gen->vage = vage;
   gen->pair_bytes = pair_size;
-
-  *genptr = gen;
   return 0;
 }
 
+unsigned ia_kvgen_reserved(unsigned nth) {
+  assert(nth < kv_globals.ntop);
+  return (unsigned)(kv_globals.ntop - 1 - nth);
+}
+
+void ia_kvgen_narrow(struct ia_kvgen *gen, uintmax_t span) {
+  if (span > 0 && span < kv_globals.period) {
+    gen->span = span;
+    gen->serial %= span;
+    gen->wpos = gen->wlen = 0;
+  }
+}
+
 void ia_kvgen_destroy(struct ia_kvgen **genptr) {
   struct ia_kvgen *gen = *genptr;
   if (gen) {
+    free(gen->window);
     free(gen);
     *genptr = NULL;
   }
@@ -148,17 +291,46 @@ int ia_kvgen_get(struct ia_kvgen *gen, iakv *p, char key_only) {
     p->vsize = gen->vsize;
   }
 
-  uint64_t point = gen->base + gen->serial;
-  gen->serial = (gen->serial + 1) % kv_globals.period;
-
-  char *end = kv_pair(p->vsize, gen->vage, point, gen->buf);
+  char *end = kv_pair(p->vsize, gen->vage, kv_next_point(gen), gen->buf);
   assert(end == gen->buf + kvpair_bytes(p->vsize));
   (void)end;
+  if (kv_globals.deferred && p->vsize) {
+    memcpy(&p->vseed, p->v, sizeof(p->vseed));
+    p->v = NULL;
+  }
   return 0;
 }
 
+void ia_kv_value(const iakv *kv, char *dst) {
+  uint64_t point = kv->vseed;
+  assert(kv->v == NULL && kv->vsize > 0);
+  kv_value(&point, dst, kv->vsize, 1);
+}
+
 //-----------------------------------------------------------------------------
 
+/* The keys go in the order of their points, so the key range is split by the
+ * leading digits of the points, and the prefixed keys by the groups of tenant
+ * and table first. */
+size_t ia_kv_split(unsigned nth, unsigned n, char *bound) {
+  double share = (double)nth / n;
+  unsigned skip = 0;
+
+  if (kv_globals.format == IA_KEY_PREFIX) {
+    const double at = share * kv_globals.tenants * kv_globals.tables;
+    const uint64_t group = (uint64_t)at;
+    kv_digits(group / kv_globals.tables, bound, kv_globals.tenant_len);
+    skip = kv_globals.tenant_len;
+    kv_digits(group % kv_globals.tables, bound + skip, kv_globals.table_len);
+    skip += kv_globals.table_len;
+    share = at - group;
+  }
+
+  const double total = (double)kv_globals.period * kv_globals.nspaces;
+  kv_digits((uint64_t)(total * share), bound + skip, kv_globals.point_len);
+  return skip + kv_globals.point_len;
+}
+
 struct ia_kvpool {
   struct ia_kvgen *gen;
   char *pos, *end;
@@ -178,8 +350,7 @@ int ia_kvpool_init(struct ia_kvpool **poolptr, struct ia_kvgen *gen,
   int i;
   char *dst = pool->buf;
   for (i = 0; i < pool_size; ++i) {
-    dst = kv_pair(gen->vsize, gen->vage, gen->base + gen->serial, dst);
-    gen->serial = (gen->serial + 1) % kv_globals.period;
+    dst = kv_pair(gen->vsize, gen->vage, kv_next_point(gen), dst);
   }
 
   pool->gen = gen;
@@ -191,6 +362,8 @@ int ia_kvpool_init(struct ia_kvpool **poolptr, struct ia_kvgen *gen,
   return 0;
 }
 
+void ia_kvpool_rewind(struct ia_kvpool *pool) { pool->pos = pool->buf; }
+
 void ia_kvpool_destroy(struct ia_kvpool **pool) {
   if (*pool) {
     free(*pool);
@@ -208,7 +381,10 @@ int ia_kvpool_pull(struct ia_kvpool *pool, iakv *p) {
 
   p->vsize = pool->gen->vsize;
   p->v = NULL;
-  if (p->vsize > 0) {
+  if (p->vsize > 0 && kv_globals.deferred) {
+    memcpy(&p->vseed, pool->pos, sizeof(p->vseed));
+    pool->pos += sizeof(p->vseed);
+  } else if (p->vsize > 0) {
     p->v = pool->pos;
     pool->pos += kv_globals.printable ? p->vsize + 1 : ALIGN(p->vsize);
   }
@@ -318,9 +494,34 @@ static uint64_t kv_mod2n_injection(uint64_t x) {
   }
 }
 
+/* A permutation of [0, span) for the random order, by the same means as the
+ * injection above but modulo the least power of two which covers the span,
+ * with the cycle-walking, i.e. up to two rounds on average. */
+static uint64_t kv_permute(uint64_t serial, uint64_t span) {
+  unsigned bits = 1;
+  while (bits < 64 && (UINTMAX_C(1) << bits) < span)
+    ++bits;
+  const uint64_t m = BITMASK(bits);
+  uint64_t y = serial;
+  do {
+    y = (y + UINTMAX_C(10042331536242289283) + sbox[0]) & m;
+    if (bits >= 11)
+      y = (y ^ sbox[y & (SBOX_SIZE - 1)]) & m;
+    y ^= y >> 1;
+    y = (y * UINTMAX_C(4613509448041658233)) & m;
+    y ^= (y << (bits + 1) / 2) & m;
+  } while (y >= span);
+  return y;
+}
+
 static size_t kvpair_bytes(size_t vsize) {
   size_t bytes;
-  if (kv_globals.printable) {
+  if (kv_globals.deferred && vsize > 0) {
+    /* only the seed of a value, to be rendered by ia_kv_value() */
+    bytes = (kv_globals.printable ? kv_globals.ksize + 1
+                                  : ALIGN(kv_globals.ksize)) +
+            sizeof(uint64_t);
+  } else if (kv_globals.printable) {
     bytes = kv_globals.ksize + ((vsize > 0) ? vsize + 2 : 1);
   } else {
     bytes = ALIGN(kv_globals.ksize) + ALIGN(vsize);
@@ -335,7 +536,9 @@ static __inline uint64_t remix4tail(uint64_t point) {
          (((point << 47) | (point >> 17)) + UINTMAX_C(7015912586649315971));
 }
 
-static char *kv_fill(uint64_t *point, char *dst, unsigned length) {
+/* the exact mode writes just the length bytes, without the terminating
+ * zero nor the alignment padding, and doesn't assume the dst is aligned. */
+static char *kv_fill(uint64_t *point, char *dst, unsigned length, char exact) {
   assert(length > 0);
   int left = kv_globals.width * 8;
 
@@ -354,29 +557,106 @@ static char *kv_fill(uint64_t *point, char *dst, unsigned length) {
         left = kv_globals.width * 8;
       }
     }
-    *dst++ = 0;
+    if (!exact)
+      *dst++ = 0;
   } else {
-    uint64_t *p = (void *)dst;
     for (;;) {
-      *p++ = htole64(*point);
-      length -= 8;
-      if (length <= 0)
+      const uint64_t word = htole64(*point);
+      const unsigned bytes = (exact && length < 8) ? length : 8;
+      memcpy(dst, &word, bytes);
+      dst += bytes;
+      if (length <= 8)
         break;
+      length -= 8;
       do {
         *point = remix4tail(*point);
         left += left;
       } while (left < 64);
     }
-    dst = (void *)p;
   }
 
   return dst;
 }
 
+/* a compressible value is the fresh pseudo-random head, which is repeated
+ * up to the length, so a codec finds the repeats within the value. The head
+ * is sized for the ratio by the entropy, since printable chars carry 6 bits.
+ */
+static char *kv_value(uint64_t *point, char *dst, unsigned length,
+                      char exact) {
+  const double bits = kv_globals.printable ? 6 : 8;
+  unsigned fresh = length;
+  if (kv_globals.vratio > 1)
+    fresh = (unsigned)ceil(length * bits / 8 / kv_globals.vratio);
+  if (fresh >= length)
+    return kv_fill(point, dst, length, exact);
+
+  if (fresh < 1)
+    fresh = 1;
+  kv_fill(point, dst, fresh, 1);
+  for (unsigned i = fresh; i < length; ++i)
+    dst[i] = dst[i - fresh];
+  dst += length;
+  if (!exact && kv_globals.printable)
+    *dst++ = 0;
+  else if (!exact) {
+    memset(dst, 0, ALIGN(length) - length);
+    dst += ALIGN(length) - length;
+  }
+  return dst;
+}
+
+/* the big-endian digits of the number, in the bytewise order */
+static void kv_digits(uint64_t number, char *dst, unsigned length) {
+  const unsigned radix = kv_globals.printable ? ALPHABET_CARDINALITY : 256;
+  for (unsigned i = length; i-- > 0; number /= radix)
+    dst[i] = kv_globals.printable ? alphabet_sorted[number % radix]
+                                  : (char)(number % radix);
+}
+
+static char *kv_terminate(char *dst) {
+  if (kv_globals.printable) {
+    dst[kv_globals.ksize] = 0;
+    return dst + kv_globals.ksize + 1;
+  }
+  memset(dst + kv_globals.ksize, 0,
+         ALIGN(kv_globals.ksize) - kv_globals.ksize);
+  return dst + ALIGN(kv_globals.ksize);
+}
+
+/* Renders the key of the point by the format, the same for every order, and
+ * leaves the seed of the value in place of the point. The big-endian digits
+ * of the point go first, so the keys go in the same order as the points, the
+ * random keys are followed by the scrambled tail. The prefixed key is the
+ * group of tenant and table, taken by the high part of the scrambled point,
+ * so the groups are populated evenly, and then the id. */
+static char *kv_key(uint64_t *point, char *dst) {
+  const uint64_t x = kv_mod2n_injection(*point);
+  unsigned skip = 0;
+
+  if (kv_globals.format == IA_KEY_PREFIX) {
+    const unsigned groups = kv_globals.tenants * kv_globals.tables;
+    const uint64_t group = x / (BITMASK(kv_globals.width * 8) / groups + 1);
+    kv_digits(group / kv_globals.tables, dst, kv_globals.tenant_len);
+    kv_digits(group % kv_globals.tables, dst + kv_globals.tenant_len,
+              kv_globals.table_len);
+    skip = kv_globals.tenant_len + kv_globals.table_len;
+  }
+
+  kv_digits(*point, dst + skip, kv_globals.point_len);
+  skip += kv_globals.point_len;
+  if (skip < kv_globals.ksize) {
+    uint64_t tail = x;
+    kv_fill(&tail, dst + skip, kv_globals.ksize - skip, 1);
+  }
+
+  *point = x;
+  return kv_terminate(dst);
+}
+
 static char *kv_pair(unsigned vsize, unsigned vage, uint64_t point, char *dst) {
   if (!kv_globals.debug) {
-    point = kv_mod2n_injection(point);
-    dst = kv_fill(&point, dst, kv_globals.ksize);
+    dst = kv_key(&point, dst);
   } else {
     if (kv_globals.printable) {
       dst += snprintf(dst, kv_globals.ksize + 1, "%0*" PRIu64, kv_globals.ksize,
@@ -390,7 +670,11 @@ static char *kv_pair(unsigned vsize, unsigned vage, uint64_t point, char *dst) {
 
   if (vsize) {
     point = remix4tail(point + vage);
-    dst = kv_fill(&point, dst, vsize);
+    if (kv_globals.deferred) {
+      memcpy(dst, &point, sizeof(point));
+      dst += sizeof(point);
+    } else
+      dst = kv_value(&point, dst, vsize, 0);
   }
   return dst;
 }
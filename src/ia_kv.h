@@ -15,22 +15,36 @@ struct iakv {
   size_t ksize;
   size_t vsize;
   char *k, *v;
+  uint64_t vseed; /* a deferred value when v is NULL, see ia_kv_value() */
 };
 
 struct ia_kvgen;
 
 int ia_kvgen_setup(char printable, unsigned ksize, unsigned nspaces,
-                   unsigned nsectors, uintmax_t period, int seed);
+                   unsigned nreserved, unsigned nsectors, uintmax_t period,
+                   int seed, char deferred, iakeyorder order, unsigned window,
+                   double vratio, iakeyformat format, unsigned tenants,
+                   unsigned tables);
+/* the nth of the reserved key spaces, which are above all of the nspaces */
+unsigned ia_kvgen_reserved(unsigned nth);
 int ia_kvgen_init(struct ia_kvgen **genptr, unsigned kspace, unsigned ksector,
                   unsigned vsize, unsigned vage);
+/* limits the generator to cycle over the first span keys of its key-space */
+void ia_kvgen_narrow(struct ia_kvgen *gen, uintmax_t span);
 void ia_kvgen_destroy(struct ia_kvgen **genptr);
 int ia_kvgen_get(struct ia_kvgen *gen, iakv *p, char key_only);
+/* renders a deferred value in-place, exactly vsize bytes */
+void ia_kv_value(const iakv *kv, char *dst);
+
+/* the lower bound of the nth of n even key ranges, returns its length */
+size_t ia_kv_split(unsigned nth, unsigned n, char *bound);
 
 struct ia_kvpool;
 
 int ia_kvpool_init(struct ia_kvpool **poolptr, struct ia_kvgen *gen,
                    int pool_size);
 int ia_kvpool_pull(struct ia_kvpool *pool, iakv *p);
+void ia_kvpool_rewind(struct ia_kvpool *pool);
 void ia_kvpool_destroy(struct ia_kvpool **pool);
 
 #endif /* IA_KV_H_ */
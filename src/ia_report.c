@@ -0,0 +1,531 @@
+﻿
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+#include "ioarena.h"
+#include <sys/utsname.h>
+
+#if defined(__linux__)
+#include <sys/vfs.h>
+#else
+#include <sys/mount.h>
+#include <sys/param.h>
+#endif
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+/* a trivial streaming JSON writer, enough for the report. */
+static struct {
+  FILE *file;
+  int depth;
+  char first;
+} json;
+
+static void json_escaped(const char *str) {
+  fputc('"', json.file);
+  for (; *str; ++str) {
+    const unsigned char c = *str;
+    if (c == '"' || c == '\\')
+      fprintf(json.file, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(json.file, "\\u%04x", c);
+    else
+      fputc(c, json.file);
+  }
+  fputc('"', json.file);
+}
+
+static void json_key(const char *key) {
+  fprintf(json.file, "%s\n%*s", json.first ? "" : ",", json.depth * 2, "");
+  json.first = 0;
+  if (key) {
+    json_escaped(key);
+    fputs(": ", json.file);
+  }
+}
+
+static void json_begin(const char *key, char bracket) {
+  json_key(key);
+  fputc(bracket, json.file);
+  json.depth += 1;
+  json.first = 1;
+}
+
+static void json_end(char bracket) {
+  json.depth -= 1;
+  if (!json.first)
+    fprintf(json.file, "\n%*s", json.depth * 2, "");
+  fputc(bracket, json.file);
+  json.first = 0;
+}
+
+static void json_str(const char *key, const char *value) {
+  json_key(key);
+  if (value)
+    json_escaped(value);
+  else
+    fputs("null", json.file);
+}
+
+static void json_uint(const char *key, uintmax_t value) {
+  json_key(key);
+  fprintf(json.file, "%ju", value);
+}
+
+static void json_real(const char *key, double value) {
+  json_key(key);
+  if (isfinite(value))
+    fprintf(json.file, "%.10g", value);
+  else
+    fputs("null", json.file);
+}
+
+static void json_bool(const char *key, int value) {
+  json_key(key);
+  fputs(value ? "true" : "false", json.file);
+}
+
+//-----------------------------------------------------------------------------
+
+static const char *ia_report_cpu(char *buf, size_t size) {
+#ifdef __APPLE__
+  if (sysctlbyname("machdep.cpu.brand_string", buf, &size, NULL, 0) == 0)
+    return buf;
+#endif
+  FILE *f = fopen("/proc/cpuinfo", "r");
+  if (!f)
+    return NULL;
+
+  const char *model = NULL;
+  char line[512];
+  while (!model && fgets(line, sizeof(line), f)) {
+    char *colon = strchr(line, ':');
+    if (!colon)
+      continue;
+    char *end = colon;
+    while (end > line && (end[-1] == ' ' || end[-1] == '\t'))
+      --end;
+    *end = '\0';
+    if (strcmp(line, "model name") && strcmp(line, "cpu model") &&
+        strcmp(line, "Processor") && strcmp(line, "cpu"))
+      continue;
+
+    char *value = colon + 1;
+    value += strspn(value, " \t");
+    value[strcspn(value, "\r\n")] = '\0';
+    snprintf(buf, size, "%s", value);
+    model = buf;
+  }
+  fclose(f);
+  return model;
+}
+
+static const char *ia_report_fstype(const char *path, char *buf, size_t size) {
+  struct statfs st;
+  if (statfs(path, &st))
+    return NULL;
+
+#if defined(__linux__)
+  switch ((unsigned long)st.f_type) {
+  case 0xEF53:
+    return "ext2/ext3/ext4";
+  case 0x58465342:
+    return "xfs";
+  case 0x9123683E:
+    return "btrfs";
+  case 0xF2F52010:
+    return "f2fs";
+  case 0x2FC12FC1:
+    return "zfs";
+  case 0xCA451A4E:
+    return "bcachefs";
+  case 0x3153464A:
+    return "jfs";
+  case 0x52654973:
+    return "reiserfs";
+  case 0x01021994:
+    return "tmpfs";
+  case 0x858458F6:
+    return "ramfs";
+  case 0x794C7630:
+    return "overlayfs";
+  case 0x65735546:
+    return "fuse";
+  case 0x6969:
+    return "nfs";
+  case 0x5346544E:
+    return "ntfs";
+  case 0x4D44:
+    return "vfat";
+  default:
+    snprintf(buf, size, "0x%lx", (unsigned long)st.f_type);
+    return buf;
+  }
+#else
+  snprintf(buf, size, "%s", st.f_fstypename);
+  return buf;
+#endif
+}
+
+static void ia_report_host(const char *datadir) {
+  char buf[256];
+  struct utsname uts;
+
+  json_begin("host", '{');
+  if (uname(&uts) == 0) {
+    json_str("hostname", uts.nodename);
+    json_str("kernel", uts.sysname);
+    json_str("release", uts.release);
+    json_str("version", uts.version);
+    json_str("machine", uts.machine);
+  }
+  json_str("cpu", ia_report_cpu(buf, sizeof(buf)));
+  json_uint("ncpu", sysconf(_SC_NPROCESSORS_ONLN));
+  json_uint("ram", (uintmax_t)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE));
+  json_str("datadir", datadir);
+  json_str("filesystem", ia_report_fstype(datadir, buf, sizeof(buf)));
+  json_end('}');
+}
+
+static void ia_report_config(const iaconfig *c) {
+  json_begin("config", '{');
+  json_str("driver", c->driver);
+  json_str("path", c->path);
+  json_begin("benchmarks", '[');
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++)
+    if (c->benchmark_list[bench])
+      json_str(NULL, ia_benchmarkof(bench));
+  json_end(']');
+  json_begin("options", '[');
+  for (struct iaoption *drv_opt = c->drv_opts; drv_opt; drv_opt = drv_opt->next)
+    json_str(NULL, drv_opt->arg);
+  json_end(']');
+  json_str("syncmode", ia_syncmode2str(c->syncmode));
+  json_str("walmode", ia_walmode2str(c->walmode));
+  json_str("key_order", ia_keyorder2str(c->key_order));
+  if (c->key_order == IA_ORDER_BATCH && c->key_window)
+    json_uint("key_window", c->key_window);
+  json_str("key_format", ia_keyformat2str(c->key_format));
+  if (c->key_format == IA_KEY_PREFIX) {
+    json_uint("key_tenants", c->key_tenants);
+    json_uint("key_tables", c->key_tables);
+  }
+  json_uint("count", c->count);
+  json_uint("ksize", c->ksize);
+  json_uint("vsize", c->vsize);
+  if (c->value_ratio > 1)
+    json_real("value_ratio", c->value_ratio);
+  json_uint("rthr", c->rthr);
+  json_uint("wthr", c->wthr);
+  json_uint("batch_length", c->batch_length);
+  json_uint("txn_length", c->txn_length);
+  json_uint("get_length", c->get_length);
+  json_uint("get_budget_ms", c->get_budget_ms);
+  json_uint("miss_ratio", c->miss_ratio);
+  if (c->pin_ms < 0)
+    json_str("pin", "round");
+  else if (c->pin_ms)
+    json_uint("pin_ms", c->pin_ms);
+  if (c->shared_ratio) {
+    json_begin("contention", '{');
+    json_uint("ratio", c->shared_ratio);
+    json_uint("keys", c->shared_keys ? c->shared_keys : c->count);
+    json_end('}');
+  }
+  json_uint("nrepeat", c->nrepeat);
+  json_uint("crashes", c->crashes);
+  json_uint("kvseed", c->kvseed);
+  if (c->soak.duration) {
+    json_begin("soak", '{');
+    json_uint("duration", c->soak.duration);
+    json_uint("rate", c->soak.rate);
+    json_end('}');
+  }
+  json_bool("binary", c->binary);
+  json_bool("separate", c->separate);
+  json_bool("ignore_keynotfound", c->ignore_keynotfound);
+  json_bool("reserve", c->reserve);
+  json_bool("continuous_completing", c->continuous_completing);
+  if (c->sweep.var != IA_SWEEP_NONE) {
+    json_begin("sweep", '{');
+    json_str("var", ia_sweepvar2str(c->sweep.var));
+    json_begin("points", '[');
+    for (int i = 0; i < c->sweep.npoints; ++i)
+      json_uint(NULL, c->sweep.points[i]);
+    json_end(']');
+    json_end('}');
+  }
+  json_end('}');
+}
+
+int ia_report_open(const iaconfig *config, const char *datadir) {
+  json.file = fopen(config->json_path, "w");
+  if (!json.file) {
+    ia_log("error: %s, %s (%d)", config->json_path, strerror(errno), errno);
+    return -1;
+  }
+  json.depth = 0;
+  json.first = 1;
+
+  char started[32];
+  time_t now = time(NULL);
+  struct tm tm;
+  strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%SZ", gmtime_r(&now, &tm));
+
+  json_begin(NULL, '{');
+  json_str("started", started);
+  ia_report_config(config);
+  json_begin("engine", '{');
+  json_str("name", ioarena.driver->name);
+  json_str("version",
+           ioarena.driver->version ? ioarena.driver->version() : NULL);
+  json_end('}');
+  ia_report_host(datadir);
+  json_begin("rounds", '[');
+  fflush(json.file);
+  return 0;
+}
+
+static void ia_report_latency(const char *key, ia_timestamp_t ns) {
+  json_uint(key, ns);
+}
+
+static void ia_report_bench(iabenchmark bench) {
+  iasummary sum;
+  if (ia_histogram_summary(bench, &sum))
+    return;
+
+  json_begin(ia_benchmarkof(bench), '{');
+  json_uint("n", sum.n);
+  json_uint("ops", sum.ops);
+  json_uint("volume", sum.volume);
+  json_real("wall", sum.wall);
+  json_real("rps", sum.rps);
+  json_real("ops_rate", sum.ops_rate);
+  json_real("bps", sum.bps);
+  if (sum.aborts) {
+    json_uint("aborts", sum.aborts);
+    json_real("abort_rate", sum.abort_rate);
+  }
+  json_begin("latency_ns", '{');
+  ia_report_latency("min", sum.min);
+  ia_report_latency("avg", sum.avg);
+  ia_report_latency("rms", sum.rms);
+  ia_report_latency("max", sum.max);
+  ia_report_latency("p50", sum.p50);
+  ia_report_latency("p90", sum.p90);
+  ia_report_latency("p99", sum.p99);
+  ia_report_latency("p99.9", sum.p999);
+  json_end('}');
+
+  const iahistogram *h = ia_histogram_of(bench);
+  json_begin("histogram", '[');
+  for (int i = 0; i < ST_HISTOGRAM_COUNT; i++) {
+    if (!h->buckets[i])
+      continue;
+    json_begin(NULL, '{');
+    json_uint("from_ns", i > 0 ? ia_histogram_bucket_bound(i - 1) : 0);
+    json_uint("to_ns", ia_histogram_bucket_bound(i) - 1);
+    json_uint("count", h->buckets[i]);
+    json_end('}');
+  }
+  json_end(']');
+
+  iasteady st;
+  if (ioarena.conf.soak.duration && ia_soak_steady(bench, &st) == 0) {
+    json_begin("steady_state", '{');
+    json_bool("reached", st.reached);
+    json_uint("window", st.window);
+    json_real("since", st.since);
+    json_begin("ramp_up", '{');
+    json_real("wall", st.ramp.wall);
+    json_real("rps", st.ramp.rps);
+    ia_report_latency("avg_ns", st.ramp.avg);
+    ia_report_latency("max_ns", st.ramp.max);
+    json_end('}');
+    json_begin("steady", '{');
+    json_real("wall", st.steady.wall);
+    json_real("rps", st.steady.rps);
+    ia_report_latency("avg_ns", st.steady.avg);
+    ia_report_latency("max_ns", st.steady.max);
+    json_end('}');
+    json_end('}');
+  }
+  json_end('}');
+}
+
+static void ia_report_memory(const iamemusage *mem, uintmax_t keys) {
+  json_begin("memory", '{');
+  json_uint("rss", mem->rss);
+  json_uint("rss_anon", mem->rss_anon);
+  json_uint("rss_file", mem->rss_file);
+  json_uint("pss", mem->pss);
+  json_uint("pss_anon", mem->pss_anon);
+  json_uint("pss_file", mem->pss_file);
+  json_uint("keys", keys);
+  json_real("ram_per_key", ia_histogram_ram_per_key(mem, keys));
+  json_end('}');
+}
+
+static void ia_report_timeline(void) {
+  size_t count;
+  const iatimepoint *timeline = ia_histogram_timeline(&count);
+  const char *names[IA_MAX_COUNTERS];
+  const int ncounters = ia_histogram_counters(names);
+
+  json_begin("timeline", '[');
+  for (size_t i = 0; i < count; ++i) {
+    const iatimepoint *point = &timeline[i];
+    json_begin(NULL, '{');
+    json_real("time", point->time);
+    json_real("wall", point->wall);
+    for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++) {
+      if (!point->bench[bench].n)
+        continue;
+      json_begin(ia_benchmarkof(bench), '{');
+      json_uint("n", point->bench[bench].n);
+      json_uint("ops", point->bench[bench].ops);
+      json_uint("volume", point->bench[bench].volume);
+      json_real("rps", point->bench[bench].n / point->wall);
+      ia_report_latency("min_ns", point->bench[bench].min);
+      ia_report_latency("avg_ns", point->bench[bench].avg);
+      ia_report_latency("rms_ns", point->bench[bench].rms);
+      ia_report_latency("max_ns", point->bench[bench].max);
+      json_end('}');
+    }
+    ia_report_memory(&point->mem, point->keys);
+    json_uint("disk", point->disk);
+    if (ncounters) {
+      json_begin("engine", '{');
+      for (int j = 0; j < ncounters; ++j)
+        json_real(names[j], point->counters[j]);
+      json_end('}');
+    }
+    json_end('}');
+  }
+  json_end(']');
+}
+
+static void ia_report_rusage(const iarusage *start, const iarusage *fihish) {
+  json_begin("rusage", '{');
+  json_uint("iops_read", fihish->iops_read - start->iops_read);
+  json_uint("iops_write", fihish->iops_write - start->iops_write);
+  json_uint("iops_page", fihish->iops_page - start->iops_page);
+  json_real("cpu_user", (fihish->cpu_user_ns - start->cpu_user_ns) / (double)S);
+  json_real("cpu_system",
+            (fihish->cpu_kernel_ns - start->cpu_kernel_ns) / (double)S);
+  json_uint("disk", fihish->disk);
+  json_uint("ram", fihish->ram);
+  json_real("disk_delta", (double)fihish->disk - (double)start->disk);
+  json_real("ram_delta", (double)fihish->ram - (double)start->ram);
+  ia_report_memory(&fihish->mem, ia_histogram_keys());
+
+  iaamplification amp;
+  ia_histogram_amplification(&ioarena.conf, start, fihish, &amp);
+  json_begin("amplification", '{');
+  json_uint("logical", amp.logical);
+  json_uint("allocated", amp.allocated);
+  json_uint("user_written", amp.user_written);
+  json_uint("device_written", amp.device_written);
+  json_uint("device_read", amp.device_read);
+  /* the ratios are omitted when undefined, e.g. nothing was written */
+  if (isfinite(amp.space))
+    json_real("space", amp.space);
+  if (isfinite(amp.compression))
+    json_real("compression", amp.compression);
+  if (isfinite(amp.write))
+    json_real("write", amp.write);
+  json_end('}');
+
+  iacounter counters[IA_MAX_COUNTERS];
+  const int ncounters =
+      ioarena.driver->counters
+          ? ioarena.driver->counters(counters, IA_MAX_COUNTERS)
+          : 0;
+  if (ncounters > 0) {
+    json_begin("engine", '{');
+    for (int i = 0; i < ncounters; ++i)
+      json_real(counters[i].name, counters[i].value);
+    json_end('}');
+  }
+  json_end('}');
+}
+
+void ia_report_round(const iaconfig *config, int round, int repeat,
+                     const iarusage *start, const iarusage *fihish) {
+  if (!json.file)
+    return;
+
+  json_begin(NULL, '{');
+  json_uint("round", round);
+  json_uint("repeat", repeat);
+  if (config->sweep.var != IA_SWEEP_NONE) {
+    json_begin("sweep", '{');
+    json_str("var", ia_sweepvar2str(config->sweep.var));
+    json_uint("point", config->sweep.points[round]);
+    json_end('}');
+  }
+  json_uint("rthr", config->rthr);
+  json_uint("wthr", config->wthr);
+  json_uint("txn_length", config->txn_length);
+
+  json_begin("benchmarks", '{');
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++)
+    ia_report_bench(bench);
+  json_end('}');
+  if (ioarena.scan_records) {
+    uintmax_t min, max;
+    double avg;
+    const double skew = ia_scan_skew(&min, &avg, &max);
+    json_begin("scan", '{');
+    json_uint("partitions", config->scan_partitions);
+    json_real("skew", skew);
+    json_begin("records", '[');
+    for (int nth = 0; nth < config->scan_partitions; ++nth)
+      json_uint(NULL, ioarena.scan_records[nth]);
+    json_end(']');
+    json_end('}');
+  }
+  ia_report_timeline();
+  ia_report_rusage(start, fihish);
+  json_end('}');
+  fflush(json.file);
+}
+
+void ia_report_crash(const iaconfig *config, int trial, const iacrash *r) {
+  if (!json.file)
+    return;
+
+  json_begin(NULL, '{');
+  json_uint("round", trial);
+  json_uint("txn_length", config->txn_length);
+  json_begin("crash", '{');
+  json_str("syncmode", ia_syncmode2str(config->syncmode));
+  json_uint("target", r->target);
+  json_uint("acked", r->acked);
+  json_uint("lost", r->lost);
+  json_uint("corrupted", r->corrupted);
+  json_uint("inflight", r->inflight);
+  json_uint("inflight_survived", r->inflight_survived);
+  ia_report_latency("recovery_ns", r->recovery_ns);
+  ia_report_latency("verify_ns", r->verify_ns);
+  json_bool("failed", r->failed);
+  json_end('}');
+  json_end('}');
+  fflush(json.file);
+}
+
+void ia_report_close(void) {
+  if (json.file) {
+    json_end(']');
+    json_end('}');
+    fputc('\n', json.file);
+    fclose(json.file);
+    json.file = NULL;
+  }
+}
@@ -0,0 +1,22 @@
+﻿#pragma once
+#ifndef IA_REPORT_H_
+#define IA_REPORT_H_
+
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+#include "ia_config.h"
+#include "ia_crash.h"
+#include "ia_rusage.h"
+
+int ia_report_open(const iaconfig *config, const char *datadir);
+void ia_report_round(const iaconfig *config, int round, int repeat,
+                     const iarusage *start, const iarusage *fihish);
+void ia_report_crash(const iaconfig *config, int trial, const iacrash *r);
+void ia_report_close(void);
+
+#endif /* IA_REPORT_H_ */
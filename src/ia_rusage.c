@@ -9,13 +9,117 @@
 
 #include "ioarena.h"
 
-static __thread uintmax_t diskusage;
+static __thread uintmax_t diskusage, diskalloc;
 
 static int ftw_diskspace(const char *fpath, const struct stat *sb,
                          int typeflag) {
   (void)fpath;
   (void)typeflag;
   diskusage += sb->st_size;
+  diskalloc += sb->st_blocks * (uintmax_t)512;
+  return 0;
+}
+
+static int ia_get_iousage(iarusage *dst) {
+#if defined(__linux__)
+  FILE *f = fopen("/proc/self/io", "r");
+  if (!f)
+    return -1;
+
+  char line[256];
+  uintmax_t cancelled = 0;
+  int found = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char name[64];
+    uintmax_t bytes;
+    if (sscanf(line, "%63[^:]: %ju", name, &bytes) != 2)
+      continue;
+    if (strcmp(name, "read_bytes") == 0)
+      dst->io_read_bytes = bytes, found |= 1;
+    else if (strcmp(name, "write_bytes") == 0)
+      dst->io_write_bytes = bytes, found |= 2;
+    else if (strcmp(name, "cancelled_write_bytes") == 0)
+      cancelled = bytes;
+  }
+  fclose(f);
+
+  /* the truncated dirty pages are accounted as written, but never
+   * reach the storage */
+  dst->io_write_bytes -=
+      (cancelled < dst->io_write_bytes) ? cancelled : dst->io_write_bytes;
+  return (found == 3) ? 0 : -1;
+#else
+  (void)dst;
+  return -1;
+#endif
+}
+
+#if defined(__linux__)
+static int ia_get_statm(iamemusage *dst) {
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (!f)
+    return -1;
+
+  uintmax_t size, resident, shared;
+  int rc = (fscanf(f, "%ju %ju %ju", &size, &resident, &shared) == 3) ? 0 : -1;
+  fclose(f);
+  if (rc == 0) {
+    const uintmax_t pagesize = sysconf(_SC_PAGESIZE);
+    dst->rss = resident * pagesize;
+    dst->rss_file = shared * pagesize;
+    dst->rss_anon = dst->rss - dst->rss_file;
+  }
+  return rc;
+}
+#endif /* __linux__ */
+
+int ia_get_memusage(iamemusage *dst) {
+  memset(dst, 0, sizeof(*dst));
+#if defined(__linux__)
+  /* smaps_rollup is available since linux 4.14,
+   * and the Pss_Anon/Pss_File/Pss_Shmem since 5.9 */
+  FILE *f = fopen("/proc/self/smaps_rollup", "r");
+  if (!f)
+    return ia_get_statm(dst);
+
+  char line[256];
+  uintmax_t anon = 0, shmem = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char name[64];
+    uintmax_t kb;
+    if (sscanf(line, "%63[^:]: %ju kB", name, &kb) != 2)
+      continue;
+    if (strcmp(name, "Rss") == 0)
+      dst->rss = kb << 10;
+    else if (strcmp(name, "Pss") == 0)
+      dst->pss = kb << 10;
+    else if (strcmp(name, "Pss_Anon") == 0)
+      dst->pss_anon = kb << 10;
+    else if (strcmp(name, "Pss_File") == 0)
+      dst->pss_file = kb << 10;
+    else if (strcmp(name, "Pss_Shmem") == 0)
+      shmem = kb << 10;
+    else if (strcmp(name, "Anonymous") == 0)
+      anon = kb << 10;
+  }
+  fclose(f);
+
+  dst->rss_anon = anon;
+  dst->rss_file = dst->rss - anon;
+  dst->pss_file += shmem;
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+int ia_get_diskusage(const char *datadir, uintmax_t *disk, uintmax_t *alloc) {
+  diskusage = diskalloc = 0;
+  if (datadir && ftw(datadir, ftw_diskspace, 42))
+    return -1;
+
+  *disk = diskusage;
+  *alloc = diskalloc;
   return 0;
 }
 
@@ -25,11 +129,9 @@ int ia_get_rusage(iarusage *dst, const char *datadir) {
   if (getrusage(RUSAGE_SELF, &glibc))
     return -1;
 
-  diskusage = 0;
-  if (datadir && ftw(datadir, ftw_diskspace, 42))
+  if (ia_get_diskusage(datadir, &dst->disk, &dst->disk_alloc))
     return -1;
 
-  dst->disk = diskusage;
   dst->ram = glibc.ru_maxrss;
   dst->cpu_kernel_ns =
       glibc.ru_stime.tv_sec * 1000000000ull + glibc.ru_stime.tv_usec * 1000ull;
@@ -38,6 +140,11 @@ int ia_get_rusage(iarusage *dst, const char *datadir) {
   dst->iops_read = glibc.ru_inblock;
   dst->iops_write = glibc.ru_oublock;
   dst->iops_page = glibc.ru_majflt;
+  if (ia_get_iousage(dst)) {
+    dst->io_read_bytes = dst->iops_read * (uintmax_t)512;
+    dst->io_write_bytes = dst->iops_write * (uintmax_t)512;
+  }
+  ia_get_memusage(&dst->mem);
 
   return 0;
 }
@@ -8,16 +8,31 @@
  * BSD License
  */
 
+typedef struct iamemusage iamemusage;
 typedef struct iarusage iarusage;
 
+/* in bytes, zeros if unavailable (e.g. pss on old linux kernels) */
+struct iamemusage {
+  uintmax_t rss, rss_anon, rss_file;
+  uintmax_t pss, pss_anon, pss_file;
+};
+
 struct iarusage {
   uintmax_t disk;
+  uintmax_t disk_alloc /* allocated blocks, in bytes */;
+  /* bytes which were really read/written from/to the storage,
+   * or estimated from the block operations if unavailable */
+  uintmax_t io_read_bytes;
+  uintmax_t io_write_bytes;
   size_t ram;
   uintmax_t cpu_kernel_ns;
   uintmax_t cpu_user_ns;
   uintmax_t iops_read;
   uintmax_t iops_write;
   uintmax_t iops_page;
+  iamemusage mem;
 };
 
 int ia_get_rusage(iarusage *, const char *datadir);
+int ia_get_diskusage(const char *datadir, uintmax_t *disk, uintmax_t *alloc);
+int ia_get_memusage(iamemusage *);
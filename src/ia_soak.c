@@ -0,0 +1,194 @@
+﻿
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+#include "ioarena.h"
+
+/* the moving window of the steady-state criterion, in timeline intervals */
+#define SOAK_WINDOW 60
+#define SOAK_WINDOW_MIN 3
+/* the allowed excursions, relative to the window's average */
+#define SOAK_RANGE_EXCURSION 0.2
+#define SOAK_SLOPE_EXCURSION 0.1
+
+/* "<duration>[s|m|h][:<churn_rate>]", e.g. "8h:1000" */
+int ia_soak_parse(iasoak *soak, const char *arg) {
+  char *end;
+  const long duration = strtol(arg, &end, 10);
+  if (end == arg || duration < 1)
+    return -1;
+
+  long scale = 1;
+  switch (*end) {
+  case 'h':
+    scale *= 60;
+    /* fallthrough */
+  case 'm':
+    scale *= 60;
+    /* fallthrough */
+  case 's':
+    ++end;
+    break;
+  }
+  if (duration > UINT_MAX / scale)
+    return -1;
+
+  long rate = 0;
+  if (*end == ':') {
+    const char *p = end + 1;
+    rate = strtol(p, &end, 10);
+    if (end == p || rate < 1 || rate > UINT_MAX)
+      return -1;
+  }
+  if (*end != '\0')
+    return -1;
+
+  soak->duration = duration * scale;
+  soak->rate = rate;
+  return 0;
+}
+
+/* the criterion is alike the SNIA's PTS one, i.e. both the throughput and
+ * the average latency within the window are steady when the max-min range is
+ * within 20% of the average, and the least-squares slope across the window is
+ * within 10% of the average. */
+static int ia_soak_stable(const double *x, size_t n) {
+  double sum = 0, min = x[0], max = x[0];
+  for (size_t i = 0; i < n; ++i) {
+    sum += x[i];
+    if (min > x[i])
+      min = x[i];
+    if (max < x[i])
+      max = x[i];
+  }
+
+  const double avg = sum / n;
+  if (!(avg > 0) || max - min > avg * SOAK_RANGE_EXCURSION)
+    return 0;
+
+  const double mid = (n - 1) / 2.0;
+  double sxy = 0, sxx = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sxy += (i - mid) * (x[i] - avg);
+    sxx += (i - mid) * (i - mid);
+  }
+  const double slope = sxy / sxx;
+  return fabs(slope) * n <= avg * SOAK_SLOPE_EXCURSION;
+}
+
+static void ia_soak_aggregate(const iatimepoint *timeline, size_t from,
+                              size_t to, iabenchmark bench, double *wall,
+                              double *rps, ia_timestamp_t *avg,
+                              ia_timestamp_t *max) {
+  uintmax_t n = 0;
+  double latency = 0;
+  *wall = 0;
+  *max = 0;
+  for (size_t i = from; i < to; ++i) {
+    *wall += timeline[i].wall;
+    n += timeline[i].bench[bench].n;
+    latency +=
+        timeline[i].bench[bench].avg * (double)timeline[i].bench[bench].n;
+    if (*max < timeline[i].bench[bench].max)
+      *max = timeline[i].bench[bench].max;
+  }
+  *rps = (*wall > 0) ? n / *wall : 0;
+  *avg = n ? latency / n : 0;
+}
+
+int ia_soak_steady(iabenchmark bench, iasteady *st) {
+  size_t length;
+  const iatimepoint *timeline = ia_histogram_timeline(&length);
+  memset(st, 0, sizeof(*st));
+
+  uintmax_t total = 0;
+  for (size_t i = 0; i < length; ++i)
+    total += timeline[i].bench[bench].n;
+  if (!total || length < SOAK_WINDOW_MIN)
+    return -1;
+
+  /* the window shouldn't exceed a third of the timeline,
+   * otherwise the steady-state would be the whole run at best */
+  size_t window = SOAK_WINDOW;
+  if (window > length / 3)
+    window = length / 3;
+  if (window < SOAK_WINDOW_MIN)
+    window = SOAK_WINDOW_MIN;
+  st->window = window;
+
+  double *rps = calloc(length * 2, sizeof(double));
+  if (!rps)
+    return -1;
+  double *avg = rps + length;
+  for (size_t i = 0; i < length; ++i) {
+    rps[i] = (timeline[i].wall > 0)
+                 ? timeline[i].bench[bench].n / timeline[i].wall
+                 : 0;
+    avg[i] = timeline[i].bench[bench].avg;
+  }
+
+  size_t from = length - window;
+  for (size_t i = 0; i + window <= length; ++i) {
+    if (ia_soak_stable(rps + i, window) && ia_soak_stable(avg + i, window)) {
+      st->reached = 1;
+      from = i;
+      break;
+    }
+  }
+  free(rps);
+
+  st->since = from ? timeline[from - 1].time : 0;
+  ia_soak_aggregate(timeline, 0, from, bench, &st->ramp.wall, &st->ramp.rps,
+                    &st->ramp.avg, &st->ramp.max);
+  ia_soak_aggregate(timeline, from, length, bench, &st->steady.wall,
+                    &st->steady.rps, &st->steady.avg, &st->steady.max);
+  return 0;
+}
+
+void ia_soak_print(const iaconfig *config) {
+  printf("\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> "
+         "steady-state\n");
+  FILE *csv = ia_csv_create(config, "soak");
+  printf("%6s | %8s%10s%10s%10s | %8s%10s%10s%10s\n", "bench", "ramp-up",
+         "rps", "avg", "max", "steady", "rps", "avg", "max");
+  if (csv)
+    fprintf(csv, "%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s\n", "bench",
+            "reached", "ramp_up", "ramp_rps", "ramp_avg", "ramp_max",
+            "steady", "steady_rps", "steady_avg", "steady_max");
+
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++) {
+    iasteady st;
+    if (!config->benchmark_list[bench] || ia_soak_steady(bench, &st))
+      continue;
+
+    char line[256], *s = line;
+    s += snprintf(s, line + sizeof(line) - s, "%6s | %8.1f",
+                  ia_benchmarkof(bench), st.since);
+    s += ia_snpf_val(s, line + sizeof(line) - s, st.ramp.rps, "");
+    s += ia_snpf_lat(s, line + sizeof(line) - s, st.ramp.avg);
+    s += ia_snpf_lat(s, line + sizeof(line) - s, st.ramp.max);
+    s += snprintf(s, line + sizeof(line) - s, " | %8.1f", st.steady.wall);
+    s += ia_snpf_val(s, line + sizeof(line) - s, st.steady.rps, "");
+    s += ia_snpf_lat(s, line + sizeof(line) - s, st.steady.avg);
+    s += ia_snpf_lat(s, line + sizeof(line) - s, st.steady.max);
+    if (!st.reached)
+      s += snprintf(s, line + sizeof(line) - s, "  (not reached)");
+    printf("%s\n", line);
+
+    if (csv)
+      fprintf(csv, "%s,\t%d,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e\n",
+              ia_benchmarkof(bench), st.reached, st.since, st.ramp.rps,
+              st.ramp.avg / (double)S, st.ramp.max / (double)S,
+              st.steady.wall, st.steady.rps, st.steady.avg / (double)S,
+              st.steady.max / (double)S);
+  }
+  printf("(the steady-state is detected within a moving window of up to %d "
+         "intervals)\n",
+         SOAK_WINDOW);
+  if (csv)
+    fclose(csv);
+}
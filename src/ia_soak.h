@@ -0,0 +1,39 @@
+﻿#pragma once
+#ifndef IA_SOAK_H_
+#define IA_SOAK_H_
+
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+typedef struct iasoak iasoak;
+typedef struct iasteady iasteady;
+
+#include "ia_config.h"
+#include "ia_time.h"
+
+struct iasoak {
+  unsigned duration /* seconds, zero if not a soak */;
+  unsigned rate /* churn (insert+delete) per second, zero for unlimited */;
+};
+
+/* the ramp-up and the steady-state figures of a benchmark, see
+ * ia_soak_steady() for the criterion */
+struct iasteady {
+  int reached;
+  size_t window /* in timeline intervals */;
+  double since /* seconds from the round start */;
+  struct {
+    double wall, rps;
+    ia_timestamp_t avg, max;
+  } ramp, steady;
+};
+
+int ia_soak_parse(iasoak *soak, const char *arg);
+int ia_soak_steady(iabenchmark bench, iasteady *st);
+void ia_soak_print(const iaconfig *config);
+
+#endif /* IA_SOAK_H_ */
@@ -0,0 +1,382 @@
+﻿
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+#include "ioarena.h"
+
+struct iasweeprow {
+  int point;
+  iasummary bench[IA_MAX];
+  iarusage rusage;
+  double wall;
+  double spread[IA_MAX] /* of the ops/s over the repeats */;
+};
+
+/* each repeat of a point is kept, these are aggregated by the median */
+struct iasweeppoint {
+  int nruns;
+  struct iasweeprow *runs;
+};
+
+static struct iasweeppoint points[IA_SWEEP_MAX];
+static struct iasweeprow rows[IA_SWEEP_MAX];
+
+const char *ia_sweepvar2str(iasweepvar var) {
+  switch (var) {
+  case IA_SWEEP_NONE:
+    return "none";
+  case IA_SWEEP_TXN:
+    return "txn";
+  case IA_SWEEP_RTHR:
+    return "r";
+  case IA_SWEEP_WTHR:
+    return "w";
+  case IA_SWEEP_THREADS:
+    return "rw";
+  default:
+    return "???";
+  }
+}
+
+static int ia_sweep_range(iasweep *sw, const char *item, size_t len) {
+  char buf[64], *end;
+  if (len == 0 || len >= sizeof(buf))
+    return -1;
+  memcpy(buf, item, len);
+  buf[len] = '\0';
+
+  /* "N", "N..M" for powers of two, or "N..M+K" for the step K. */
+  long from = strtol(buf, &end, 10), to = from, step = 0;
+  if (end == buf || from < 0)
+    return -1;
+  if (strncmp(end, "..", 2) == 0) {
+    const char *p = end + 2;
+    to = strtol(p, &end, 10);
+    if (end == p || to < from)
+      return -1;
+    if (*end == '+') {
+      p = end + 1;
+      step = strtol(p, &end, 10);
+      if (end == p || step < 1)
+        return -1;
+    }
+  }
+  if (*end != '\0' || to > INT_MAX)
+    return -1;
+
+  for (long v = from; v <= to; v = step ? v + step : (v ? v * 2 : 1)) {
+    if (sw->npoints == IA_SWEEP_MAX)
+      return -1;
+    sw->points[sw->npoints++] = v;
+  }
+  return 0;
+}
+
+int ia_sweep_parse(iasweep *sw, const char *arg) {
+  const char *eq = strchr(arg, '=');
+  const size_t name_len = eq ? (size_t)(eq - arg) : strlen(arg);
+
+  sw->var = IA_SWEEP_NONE;
+  sw->npoints = 0;
+  for (iasweepvar var = IA_SWEEP_TXN; var <= IA_SWEEP_THREADS; var++) {
+    const char *name = ia_sweepvar2str(var);
+    if (name_len == strlen(name) && strncasecmp(arg, name, name_len) == 0)
+      sw->var = var;
+  }
+  if (sw->var == IA_SWEEP_NONE)
+    return -1;
+
+  char dflt[32] = "1..4096";
+  if (sw->var != IA_SWEEP_TXN)
+    snprintf(dflt, sizeof(dflt), "1..%ld", sysconf(_SC_NPROCESSORS_ONLN));
+  const char *list = eq ? eq + 1 : dflt;
+  while (*list) {
+    const char *comma = strchr(list, ',');
+    const size_t len = comma ? (size_t)(comma - list) : strlen(list);
+    if (ia_sweep_range(sw, list, len))
+      return -1;
+    list += comma ? len + 1 : len;
+  }
+
+  for (int i = 0; i < sw->npoints; ++i)
+    if (sw->var == IA_SWEEP_TXN && sw->points[i] < 1)
+      return -1;
+  return sw->npoints ? 0 : -1;
+}
+
+void ia_sweep_apply(iaconfig *config, int nth) {
+  const int point = config->sweep.points[nth];
+  switch (config->sweep.var) {
+  case IA_SWEEP_TXN:
+    config->txn_length = point;
+    break;
+  case IA_SWEEP_RTHR:
+    config->rthr = point;
+    break;
+  case IA_SWEEP_WTHR:
+    config->wthr = point;
+    break;
+  case IA_SWEEP_THREADS:
+    config->rthr = config->wthr = point;
+    break;
+  default:
+    assert(0);
+  }
+  snprintf(ioarena.round_tag, sizeof(ioarena.round_tag), "%s%d",
+           ia_sweepvar2str(config->sweep.var), point);
+  ia_log("sweep: %s = %d (%d of %d)", ia_sweepvar2str(config->sweep.var),
+         point, nth + 1, config->sweep.npoints);
+}
+
+int ia_sweep_collect(const iaconfig *config, int nth, int repeat,
+                     const iarusage *start, const iarusage *finish) {
+  if (repeat >= points[nth].nruns) {
+    struct iasweeprow *runs =
+        realloc(points[nth].runs, (repeat + 1) * sizeof(struct iasweeprow));
+    if (!runs)
+      return -1;
+    points[nth].runs = runs;
+    points[nth].nruns = repeat + 1;
+  }
+
+  struct iasweeprow *row = &points[nth].runs[repeat];
+  memset(row, 0, sizeof(*row));
+  row->point = config->sweep.points[nth];
+  ia_timestamp_t begin_ns = 0, end_ns = 0;
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++) {
+    const iasummary *sum = &row->bench[bench];
+    if (ia_histogram_summary(bench, &row->bench[bench]))
+      continue;
+    if (!begin_ns || begin_ns > sum->begin_ns)
+      begin_ns = sum->begin_ns;
+    if (end_ns < sum->end_ns)
+      end_ns = sum->end_ns;
+  }
+  row->wall = (end_ns - begin_ns) / (double)S;
+
+  row->rusage.disk = finish->disk;
+  row->rusage.ram = finish->ram;
+  row->rusage.cpu_kernel_ns = finish->cpu_kernel_ns - start->cpu_kernel_ns;
+  row->rusage.cpu_user_ns = finish->cpu_user_ns - start->cpu_user_ns;
+  row->rusage.iops_read = finish->iops_read - start->iops_read;
+  row->rusage.iops_write = finish->iops_write - start->iops_write;
+  row->rusage.iops_page = finish->iops_page - start->iops_page;
+  return 0;
+}
+
+static int ia_sweep_cmp(const void *a, const void *b) {
+  const double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double ia_sweep_median(double *v, int n) {
+  qsort(v, n, sizeof(double), ia_sweep_cmp);
+  return (n & 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+#define IA_SWEEP_MEDIAN(dst, field, type)                                      \
+  do {                                                                         \
+    for (int r = 0; r < n; ++r)                                                \
+      v[r] = (double)pt->runs[r].field;                                        \
+    dst = (type)ia_sweep_median(v, n);                                         \
+  } while (0)
+
+/* aggregates the repeats of a point by the median of each figure, the
+ * spread is the range of the ops/s relative to its median. */
+static int ia_sweep_aggregate(int nth, struct iasweeprow *row) {
+  const struct iasweeppoint *pt = &points[nth];
+  const int n = pt->nruns;
+  double *v = n ? malloc(n * sizeof(double)) : NULL;
+  if (!v)
+    return -1;
+
+  *row = pt->runs[0];
+  IA_SWEEP_MEDIAN(row->wall, wall, double);
+  IA_SWEEP_MEDIAN(row->rusage.cpu_user_ns, rusage.cpu_user_ns, uintmax_t);
+  IA_SWEEP_MEDIAN(row->rusage.cpu_kernel_ns, rusage.cpu_kernel_ns, uintmax_t);
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++) {
+    iasummary *sum = &row->bench[bench];
+    row->spread[bench] = 0;
+    if (!sum->n)
+      continue;
+    IA_SWEEP_MEDIAN(sum->n, bench[bench].n, uintmax_t);
+    IA_SWEEP_MEDIAN(sum->ops, bench[bench].ops, uintmax_t);
+    IA_SWEEP_MEDIAN(sum->rps, bench[bench].rps, double);
+    IA_SWEEP_MEDIAN(sum->avg, bench[bench].avg, ia_timestamp_t);
+    IA_SWEEP_MEDIAN(sum->p50, bench[bench].p50, ia_timestamp_t);
+    IA_SWEEP_MEDIAN(sum->p99, bench[bench].p99, ia_timestamp_t);
+    IA_SWEEP_MEDIAN(sum->max, bench[bench].max, ia_timestamp_t);
+    IA_SWEEP_MEDIAN(sum->ops_rate, bench[bench].ops_rate, double);
+    /* the v[] is sorted by the last median */
+    if (sum->ops_rate > 0)
+      row->spread[bench] = (v[n - 1] - v[0]) / sum->ops_rate;
+  }
+  free(v);
+  return 0;
+}
+
+#undef IA_SWEEP_MEDIAN
+
+static void ia_sweep_print_txn(const iaconfig *config, const char *var,
+                               FILE *csv) {
+  printf("%6s | bench%9s%8s%9s%10s%10s%10s%10s%10s\n", var, "ops/s", "spread",
+         "txn/s", "op-avg", "txn-avg", "txn-p50", "txn-p99", "txn-max");
+  if (csv)
+    fprintf(csv, "%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s\n", var,
+            "bench", "ops_rate", "ops_spread", "txn_rate", "op_avg", "txn_avg",
+            "txn_p50", "txn_p99", "txn_max");
+
+  for (int nth = 0; nth < config->sweep.npoints; ++nth) {
+    const struct iasweeprow *row = &rows[nth];
+    for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++) {
+      const iasummary *sum = &row->bench[bench];
+      if (!sum->n)
+        continue;
+
+      const ia_timestamp_t op_avg =
+          sum->ops ? sum->avg * sum->n / sum->ops : sum->avg;
+      char line[1024], *s = line;
+      s += snprintf(s, line + sizeof(line) - s, "%6d | %5s", row->point,
+                    ia_benchmarkof(bench));
+      s += ia_snpf_val(s, line + sizeof(line) - s, sum->ops_rate, "");
+      s += snprintf(s, line + sizeof(line) - s, " %6.1f%%",
+                    row->spread[bench] * 1e2);
+      s += ia_snpf_val(s, line + sizeof(line) - s, sum->rps, "");
+      s += ia_snpf_lat(s, line + sizeof(line) - s, op_avg);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, sum->avg);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, sum->p50);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, sum->p99);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, sum->max);
+      printf("%s\n", line);
+
+      if (csv)
+        fprintf(csv, "%d,\t%s,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e\n",
+                row->point, ia_benchmarkof(bench), sum->ops_rate,
+                row->spread[bench], sum->rps, op_avg / (double)S,
+                sum->avg / (double)S, sum->p50 / (double)S,
+                sum->p99 / (double)S, sum->max / (double)S);
+    }
+  }
+}
+
+/* the readers do the lookups and the scan, the writers do the rest,
+ * see ia_round() */
+static int ia_sweep_swept(iasweepvar var, iabenchmark bench) {
+  const int read =
+      bench == IA_ITERATE || bench == IA_GET || bench == IA_GETMISS;
+  return var == IA_SWEEP_THREADS || (var == IA_SWEEP_RTHR) == read;
+}
+
+/* the ops/s of the swept side per thread, i.e. the other side which is
+ * fixed (e.g. the writers while sweeping the readers) is not mixed in. */
+static double ia_sweep_per_thread(iasweepvar var,
+                                  const struct iasweeprow *row) {
+  double ops_rate = 0;
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++)
+    if (ia_sweep_swept(var, bench))
+      ops_rate += row->bench[bench].ops_rate;
+  /* zero threads means the single main/common thread */
+  return ops_rate / (row->point ? row->point : 1);
+}
+
+static void ia_sweep_print_threads(const iaconfig *config, const char *var,
+                                   FILE *csv) {
+  const iasweepvar sweep = config->sweep.var;
+  const char *side = (sweep == IA_SWEEP_RTHR)   ? "read"
+                     : (sweep == IA_SWEEP_WTHR) ? "write"
+                                                : "total";
+
+  /* the scale is of the swept side's ops/s per thread, relative to the
+   * first point, the CPU figures are per round, i.e. over all benchmarks. */
+  printf("scale: %s ops/s per thread relative to %s=%d\n", side, var,
+         rows[0].point);
+  printf("%6s | bench%9s%8s%10s%10s%8s%11s%8s\n", var, "ops/s", "spread",
+         "p50", "p99", "cpu%", "ops/cpu-s", "scale");
+  if (csv)
+    fprintf(csv, "%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s,\t%s_scale\n", var,
+            "bench", "ops_rate", "ops_spread", "p50", "p99", "cpu_util",
+            "ops_per_cpu_sec", side);
+
+  const double base = ia_sweep_per_thread(sweep, &rows[0]);
+  for (iabenchmark bench = IA_SET; bench < IA_MAX; bench++) {
+    for (int nth = 0; nth < config->sweep.npoints; ++nth) {
+      const struct iasweeprow *row = &rows[nth];
+      const iasummary *sum = &row->bench[bench];
+      if (!sum->n)
+        continue;
+
+      uintmax_t ops = 0;
+      for (iabenchmark i = IA_SET; i < IA_MAX; i++)
+        ops += row->bench[i].ops;
+      const double cpu =
+          (row->rusage.cpu_user_ns + row->rusage.cpu_kernel_ns) / (double)S;
+      const double util = (row->wall > 0) ? cpu * 1e2 / row->wall : 0;
+      const double ops_cpu = (cpu > 0) ? ops / cpu : 0;
+      const double scale = (base > 0 && ia_sweep_swept(sweep, bench))
+                               ? ia_sweep_per_thread(sweep, row) / base
+                               : NAN;
+
+      char line[1024], *s = line;
+      s += snprintf(s, line + sizeof(line) - s, "%6d | %5s", row->point,
+                    ia_benchmarkof(bench));
+      s += ia_snpf_val(s, line + sizeof(line) - s, sum->ops_rate, "");
+      s += snprintf(s, line + sizeof(line) - s, " %6.1f%%",
+                    row->spread[bench] * 1e2);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, sum->p50);
+      s += ia_snpf_lat(s, line + sizeof(line) - s, sum->p99);
+      s += snprintf(s, line + sizeof(line) - s, "%7.1f%%", util);
+      s += ia_snpf_val(s, line + sizeof(line) - s, ops_cpu, "");
+      if (isfinite(scale))
+        s += snprintf(s, line + sizeof(line) - s, " %6.1f%%", scale * 1e2);
+      else
+        s += snprintf(s, line + sizeof(line) - s, " %7s", "-");
+      printf("%s\n", line);
+
+      if (csv)
+        fprintf(csv, "%d,\t%s,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e,\t%e\n",
+                row->point, ia_benchmarkof(bench), sum->ops_rate,
+                row->spread[bench], sum->p50 / (double)S,
+                sum->p99 / (double)S, util / 1e2, ops_cpu, scale);
+    }
+  }
+}
+
+void ia_sweep_print(const iaconfig *config) {
+  const char *var = ia_sweepvar2str(config->sweep.var);
+  ioarena.round_tag[0] = '\0';
+
+  int rc = 0;
+  for (int nth = 0; !rc && nth < config->sweep.npoints; ++nth)
+    rc = ia_sweep_aggregate(nth, &rows[nth]);
+  if (rc) {
+    ia_log("error: sweep, out of memory");
+    goto bailout;
+  }
+
+  printf("\n>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> "
+         "sweep(%s)\n",
+         var);
+  if (config->nrepeat > 1)
+    printf("the median of %d repeats, the spread is the ops/s range\n",
+           config->nrepeat);
+  FILE *csv = ia_csv_create(config, "sweep");
+
+  if (config->sweep.var == IA_SWEEP_TXN)
+    ia_sweep_print_txn(config, var, csv);
+  else
+    ia_sweep_print_threads(config, var, csv);
+
+  if (csv)
+    fclose(csv);
+
+bailout:
+  for (int nth = 0; nth < config->sweep.npoints; ++nth) {
+    free(points[nth].runs);
+    points[nth].runs = NULL;
+    points[nth].nruns = 0;
+  }
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+#ifndef IA_SWEEP_H_
+#define IA_SWEEP_H_
+
+/*
+ * ioarena: embedded storage benchmarking
+ *
+ * Copyright (c) ioarena authors
+ * BSD License
+ */
+
+typedef struct iasweep iasweep;
+
+#include "ia_config.h"
+#include "ia_rusage.h"
+
+typedef enum {
+  IA_SWEEP_NONE,
+  IA_SWEEP_TXN,
+  IA_SWEEP_RTHR,
+  IA_SWEEP_WTHR,
+  IA_SWEEP_THREADS
+} iasweepvar;
+
+#define IA_SWEEP_MAX 64
+
+struct iasweep {
+  iasweepvar var;
+  int npoints;
+  int points[IA_SWEEP_MAX];
+};
+
+const char *ia_sweepvar2str(iasweepvar var);
+int ia_sweep_parse(iasweep *sw, const char *arg);
+void ia_sweep_apply(iaconfig *config, int nth);
+int ia_sweep_collect(const iaconfig *config, int nth, int repeat,
+                     const iarusage *start, const iarusage *finish);
+void ia_sweep_print(const iaconfig *config);
+
+#endif /* IA_SWEEP_H_ */
@@ -12,6 +12,7 @@
 #define _GNU_SOURCE 1
 
 #include <assert.h>
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <ftw.h>
@@ -58,11 +59,13 @@ int pthread_barrier_wait(pthread_barrier_t *barrier);
 
 typedef enum {
   IA_SET,
+  IA_UPDATE /* a read-modify-write, done by crud steps of the driver */,
   IA_BATCH,
   IA_CRUD,
   IA_DELETE,
   IA_ITERATE,
   IA_GET,
+  IA_GETMISS /* a get of keys which are never written */,
   IA_MAX
 } iabenchmark;
 
@@ -70,15 +73,32 @@ typedef enum { IA_SYNC, IA_LAZY, IA_NOSYNC } iasyncmode;
 
 typedef enum { IA_WAL_INDEF, IA_WAL_ON, IA_WAL_OFF } iawalmode;
 
+typedef enum {
+  IA_ORDER_RANDOM /* the scrambled keys, the default */,
+  IA_ORDER_ASC,
+  IA_ORDER_DESC,
+  IA_ORDER_BATCH /* the scrambled keys, sorted within each window */
+} iakeyorder;
+
+typedef enum {
+  IA_KEY_RANDOM /* the scrambled chars or bytes, the default */,
+  IA_KEY_INT /* the fixed-width big-endian integers */,
+  IA_KEY_PREFIX /* <tenant><table><id>, with the shared prefixes */
+} iakeyformat;
+
 #include "ia.h"
 #include "ia_benchmark.h"
 #include "ia_build.h"
 #include "ia_config.h"
+#include "ia_crash.h"
 #include "ia_driver.h"
 #include "ia_histogram.h"
 #include "ia_kv.h"
 #include "ia_log.h"
+#include "ia_report.h"
 #include "ia_rusage.h"
+#include "ia_soak.h"
+#include "ia_sweep.h"
 #include "ia_time.h"
 
 extern ia ioarena;